@@ -0,0 +1,179 @@
+//
+// a cache line blocked bloom filter
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include <stdlib.h>
+#include <string.h>
+#include "bloom_filter.h"
+
+#define BLOOM_COUNTER_MAX        255
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * initialize a bloom filter
+ *
+ * @param bf bloom filter
+ * @param numElements expected number of elements
+ * @param bitsPerElement bits per element, BLOOM_DEFAULT_BITS if 0
+ * @param counting non zero to allow delBloomFilter()
+ * @return 0 on success, -1 on memory allocation failure
+ */
+int
+initBloomFilter(BloomFilter* bf, int numElements, int bitsPerElement, int counting)
+{
+   long  bits;
+   int   n = 1;
+   void* blocks;
+
+   if(bitsPerElement <= 0)
+   {
+      bitsPerElement = BLOOM_DEFAULT_BITS;
+   }
+
+   bits = (long)numElements * bitsPerElement;
+   while((long)n * BLOOM_BLOCK_BITS < bits)
+   {
+      n *= 2;
+   }
+
+   if(posix_memalign(&blocks, sizeof(BloomBlock), sizeof(BloomBlock) * n) != 0)
+   {
+      return -1;
+   }
+
+   bf->counters = NULL;
+   if(counting)
+   {
+      bf->counters = (unsigned char*)calloc(n, BLOOM_BLOCK_BITS);
+      if(bf->counters == NULL)
+      {
+         free(blocks);
+         return -1;
+      }
+   }
+
+   bf->blocks     = (BloomBlock*)blocks;
+   bf->numBlocks  = n;
+
+   // k = bits per element * ln 2 minimizes false positives
+   bf->numHashes  = (bitsPerElement * 69 + 50) / 100;
+   if(bf->numHashes < 1)
+   {
+      bf->numHashes = 1;
+   }
+   else if(bf->numHashes > BLOOM_MAX_HASHES)
+   {
+      bf->numHashes = BLOOM_MAX_HASHES;
+   }
+
+   clearBloomFilter(bf);
+   return 0;
+}
+
+/**
+ * deinitialize a bloom filter
+ *
+ * @param bf bloom filter
+ */
+void
+deinitBloomFilter(BloomFilter* bf)
+{
+   free(bf->blocks);
+   free(bf->counters);
+   bf->blocks     = NULL;
+   bf->counters   = NULL;
+}
+
+/**
+ * remove all the keys from bloom filter
+ *
+ * @param bf bloom filter
+ */
+void
+clearBloomFilter(BloomFilter* bf)
+{
+   memset(bf->blocks, 0, sizeof(BloomBlock) * bf->numBlocks);
+   if(bf->counters != NULL)
+   {
+      memset(bf->counters, 0, (size_t)bf->numBlocks * BLOOM_BLOCK_BITS);
+   }
+}
+
+/**
+ * add a hash value to bloom filter
+ *
+ * @param bf bloom filter
+ * @param hv hash value of key
+ */
+void
+addBloomFilter(BloomFilter* bf, unsigned int hv)
+{
+   uint32_t       h1, h2, bit;
+   BloomBlock*    b = getBloomBlock(bf, hv, &h1, &h2);
+   unsigned char* c = NULL;
+   int            i;
+
+   if(bf->counters != NULL)
+   {
+      c = &bf->counters[(b - bf->blocks) * BLOOM_BLOCK_BITS];
+   }
+
+   for(i = 0; i < bf->numHashes; i++)
+   {
+      bit = (h1 + i * h2) >> 23;
+      b->words[bit >> 6] |= 1ull << (bit & 63);
+
+      // a saturated counter sticks. the bit can never be cleared safely
+      if(c != NULL && c[bit] < BLOOM_COUNTER_MAX)
+      {
+         c[bit]++;
+      }
+   }
+}
+
+/**
+ * delete a hash value from counting bloom filter
+ * the hash value must have been added. ignored for non counting filter
+ *
+ * @param bf bloom filter
+ * @param hv hash value of key
+ */
+void
+delBloomFilter(BloomFilter* bf, unsigned int hv)
+{
+   uint32_t       h1, h2, bit;
+   BloomBlock*    b;
+   unsigned char* c;
+   int            i;
+
+   if(bf->counters == NULL)
+   {
+      return;
+   }
+
+   b = getBloomBlock(bf, hv, &h1, &h2);
+   c = &bf->counters[(b - bf->blocks) * BLOOM_BLOCK_BITS];
+
+   for(i = 0; i < bf->numHashes; i++)
+   {
+      bit = (h1 + i * h2) >> 23;
+      if(c[bit] == 0 || c[bit] == BLOOM_COUNTER_MAX)
+      {
+         continue;
+      }
+
+      if(--c[bit] == 0)
+      {
+         b->words[bit >> 6] &= ~(1ull << (bit & 63));
+      }
+   }
+}
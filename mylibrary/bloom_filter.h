@@ -0,0 +1,92 @@
+//
+// a cache line blocked bloom filter
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __BLOOM_FILTER_DEF_H__
+#define __BLOOM_FILTER_DEF_H__
+
+#include <stdint.h>
+
+#define BLOOM_BLOCK_BITS         512            /** one 64 byte cache line   */
+#define BLOOM_BLOCK_WORDS        (BLOOM_BLOCK_BITS / 64)
+#define BLOOM_MAX_HASHES         16
+#define BLOOM_DEFAULT_BITS       10             /** bits per element, ~1% false positive */
+
+/**
+ * a bloom filter block
+ */
+typedef struct bloom_block
+{
+   uint64_t          words[BLOOM_BLOCK_WORDS];
+} __attribute__((aligned(64))) BloomBlock;
+
+/**
+ * a blocked bloom filter
+ *
+ * all the bits for a key are in a single cache line block,
+ * so a check costs one cache line access.
+ * keys are given as 32 bit hash values, so that a hash table
+ * can share the hash value it computes anyway.
+ * a counting filter keeps a counter per bit to support deletion
+ */
+typedef struct bloom_filter
+{
+   int               numBlocks;        /** number of blocks, power of 2       */
+   int               numHashes;        /** bits set per key                   */
+   BloomBlock*       blocks;           /** bit blocks                         */
+   unsigned char*    counters;         /** per bit counters, NULL if not counting */
+} BloomFilter;
+
+extern int initBloomFilter(BloomFilter* bf, int numElements, int bitsPerElement, int counting);
+extern void deinitBloomFilter(BloomFilter* bf);
+extern void clearBloomFilter(BloomFilter* bf);
+extern void addBloomFilter(BloomFilter* bf, unsigned int hv);
+extern void delBloomFilter(BloomFilter* bf, unsigned int hv);
+
+/**
+ * picks a block and bit positions for a hash value.
+ * the 32 bit hash is spread over 64 bits. block index comes from
+ * the upper half, bit positions from double hashing of the lower half
+ */
+static inline BloomBlock*
+getBloomBlock(BloomFilter* bf, unsigned int hv, uint32_t* h1, uint32_t* h2)
+{
+   uint64_t x = (uint64_t)hv * 0x9e3779b97f4a7c15ull;
+
+   x ^= x >> 29;
+   *h1 = (uint32_t)x;
+   *h2 = ((uint32_t)(x >> 32) * 0x85ebca6b) | 1;
+   return &bf->blocks[(x >> 32) & (bf->numBlocks - 1)];
+}
+
+/**
+ * check if a hash value may be in bloom filter
+ *
+ * @param bf bloom filter
+ * @param hv hash value of key
+ * @return 0 if definitely not in filter, 1 if it may be
+ */
+static inline int
+checkBloomFilter(BloomFilter* bf, unsigned int hv)
+{
+   uint32_t    h1, h2, bit;
+   BloomBlock* b = getBloomBlock(bf, hv, &h1, &h2);
+   int         i;
+
+   for(i = 0; i < bf->numHashes; i++)
+   {
+      bit = (h1 + i * h2) >> 23;
+      if(!(b->words[bit >> 6] & (1ull << (bit & 63))))
+      {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+#endif //!__BLOOM_FILTER_DEF_H__
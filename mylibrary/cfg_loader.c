@@ -14,6 +14,7 @@
 #include <unistd.h>
 #include "cfg_loader.h"
 #include "mem_tracker.h"
+#include "obj_pool.h"
 
 extern int yyparse(void);
 extern void setCurrentConfig(ConfigCB* cfg);
@@ -21,11 +22,148 @@ extern void setInputFile(FILE* fp);
 
 #define DEFAULT_TAB_STOP      "\t\t\t\t"
 
+#define CONFIG_INDEX_MIN_SIZE 64
+
+#define CONFIG_OBJS_PER_SLAB  64
+
+/**
+ * name index entry
+ * all the parameters with the same name are linked here in parm_list order
+ */
+typedef struct
+{
+   HashElement       he;               /** hash element for name index */
+   char*             name;             /** parameter name */
+   struct list_head  params;           /** ConfigParameter list linked by same_name */
+} ConfigName;
+
+//
+// parameters, values and names are small, fixed size and allocated
+// one by one while parsing. they come from pools shared by all configs
+//
+static ObjPool paramPool = OBJ_POOL_INIT(paramPool, sizeof(ConfigParameter),
+                                          CONFIG_OBJS_PER_SLAB, OBJ_POOL_THREAD_SAFE);
+static ObjPool valuePool = OBJ_POOL_INIT(valuePool, sizeof(ParamValue),
+                                          CONFIG_OBJS_PER_SLAB, OBJ_POOL_THREAD_SAFE);
+static ObjPool namePool  = OBJ_POOL_INIT(namePool, sizeof(ConfigName),
+                                          CONFIG_OBJS_PER_SLAB, OBJ_POOL_THREAD_SAFE);
+
 static void
 __init_config(ConfigCB* cfg)
 {
    INIT_LIST_HEAD(&cfg->parm_list);
-   cfg->numParams = 0;
+   cfg->numParams    = 0;
+   cfg->index_failed = 0;
+   memset(&cfg->name_index, 0, sizeof(cfg->name_index));
+}
+
+//
+// name index is read only for lookups, so that loaded configuration
+// can be looked up from multiple threads
+//
+static ConfigName*
+lookupName(ConfigCB* cfg, char* name)
+{
+   if(cfg->name_index.buckets == NULL)
+   {
+      return NULL;
+   }
+   return (ConfigName*)peekHash(&cfg->name_index, name);
+}
+
+//
+// returns 0 on success, -1 when the parameter couldn't be indexed
+//
+static int
+indexParameter(ConfigCB* cfg, ConfigParameter* param)
+{
+   ConfigName* n;
+
+   INIT_LIST_HEAD(&param->same_name);
+
+   if(cfg->name_index.buckets == NULL)
+   {
+      initHashVarKey(&cfg->name_index, CONFIG_INDEX_MIN_SIZE, offsetof(ConfigName, he),
+            offsetof(ConfigName, name), HASH_KEY_INDIRECT, NULL, NULL);
+      if(cfg->name_index.buckets == NULL)
+      {
+         return -1;
+      }
+   }
+
+   n = lookupName(cfg, param->name);
+   if(n == NULL)
+   {
+      n = (ConfigName*)alloc_obj(&namePool);
+      if(n == NULL)
+      {
+         return -1;
+      }
+
+      n->name = strdup(param->name);
+      if(n->name == NULL)
+      {
+         free_obj(&namePool, n);
+         return -1;
+      }
+      INIT_LIST_HEAD(&n->params);
+      addHash(&cfg->name_index, n);
+   }
+
+   // parameters are always added at the end of parm_list. so is the name list
+   list_add_tail(&param->same_name, &n->params);
+   return 0;
+}
+
+//
+// name entry is kept even if its last parameter is gone
+// so that iterate_over_name() can delete parameters while iterating
+//
+static void
+unindexParameter(ConfigCB* cfg, ConfigParameter* param)
+{
+   list_del_init(&param->same_name);
+}
+
+static void
+freeName(HashContext* hash, void* element, void* priv)
+{
+   ConfigName* n = (ConfigName*)element;
+
+   free(n->name);
+   free_obj(&namePool, n);
+}
+
+static void
+freeNameIndex(ConfigCB* cfg)
+{
+   if(cfg->name_index.buckets == NULL)
+   {
+      return;
+   }
+
+   iterateHash(&cfg->name_index, freeName, NULL);
+   deinitHash(&cfg->name_index);
+   memset(&cfg->name_index, 0, sizeof(cfg->name_index));
+}
+
+//
+// an index missing some parameters would make lookups miss them.
+// once a parameter fails to be indexed, the index is dropped for good
+// and lookups fall back to scanning parm_list
+//
+static void
+dropNameIndex(ConfigCB* cfg)
+{
+   ConfigParameter* p;
+
+   freeNameIndex(cfg);
+
+   list_for_each_entry(p, &cfg->parm_list, next)
+   {
+      INIT_LIST_HEAD(&p->same_name);
+   }
+   cfg->index_failed = 1;
 }
 
 static ConfigParameter*
@@ -33,13 +171,14 @@ allocConfigParam(void)
 {
    ConfigParameter* param;
 
-   param = (ConfigParameter*)malloc(sizeof(ConfigParameter));
+   param = (ConfigParameter*)alloc_obj(&paramPool);
    if(param == NULL)
    {
       return NULL;
    }
 
    INIT_LIST_HEAD(&param->next);
+   INIT_LIST_HEAD(&param->same_name);
 
    return param;
 }
@@ -56,7 +195,7 @@ allocPValue(ParamType type, void* value)
 {
    ParamValue* pv;
 
-   pv = (ParamValue*)malloc(sizeof(ParamValue));
+   pv = (ParamValue*)alloc_obj(&valuePool);
    if(pv == NULL)
    {
       return NULL;
@@ -132,7 +271,7 @@ freePValue(ParamValue* pval)
       }
       free(pval->array);
    }
-   free(pval);
+   free_obj(&valuePool, pval);
 }
 
 static void
@@ -140,7 +279,7 @@ freeConfigParam(ConfigParameter* p)
 {
    freePValue(p->val);
    free(p->name);
-   free(p);
+   free_obj(&paramPool, p);
 }
 
 /**
@@ -155,6 +294,11 @@ addParameter(ConfigCB* cfg, ConfigParameter* param)
 {
    list_add_tail(&param->next, &cfg->parm_list);
    cfg->numParams++;
+
+   if(!cfg->index_failed && indexParameter(cfg, param) != 0)
+   {
+      dropNameIndex(cfg);
+   }
 }
 
 /**
@@ -168,6 +312,7 @@ addParameter(ConfigCB* cfg, ConfigParameter* param)
 void
 delParameter(ConfigCB* cfg, ConfigParameter* param)
 {
+   unindexParameter(cfg, param);
    list_del(&param->next);
    cfg->numParams--;
    freeConfigParam(param);
@@ -256,6 +401,10 @@ freeConfig(ConfigCB* cfg)
       list_del(&p->next);
       freeConfigParam(p);
    }
+   cfg->numParams = 0;
+
+   freeNameIndex(cfg);
+   cfg->index_failed = 0;
 }
 
 /**
@@ -287,14 +436,30 @@ iterate_over_cfg(ConfigCB* cfg, cfg_iterator it)
 void
 iterate_over_name(ConfigCB* cfg, char* name, cfg_iterator it)
 {
-   ConfigParameter* p;
+   ConfigName*       n;
+   ConfigParameter   *p, *tmp;
 
-   list_for_each_entry(p, &cfg->parm_list, next)
+   if(cfg->index_failed)
    {
-      if(strcmp(p->name, name) == 0)
+      list_for_each_entry_safe(p, tmp, &cfg->parm_list, next)
       {
-         it(cfg, p);
+         if(strcmp(p->name, name) == 0)
+         {
+            it(cfg, p);
+         }
       }
+      return;
+   }
+
+   n = lookupName(cfg, name);
+   if(n == NULL)
+   {
+      return;
+   }
+
+   list_for_each_entry_safe(p, tmp, &n->params, same_name)
+   {
+      it(cfg, p);
    }
 }
 
@@ -310,16 +475,27 @@ iterate_over_name(ConfigCB* cfg, char* name, cfg_iterator it)
 ConfigParameter*
 lookupConfig(ConfigCB* cfg, char* name)
 {
-   ConfigParameter* p;
+   ConfigName*       n;
+   ConfigParameter*  p;
 
-   list_for_each_entry(p, &cfg->parm_list, next)
+   if(cfg->index_failed)
    {
-      if(strcmp(p->name, name) == 0)
+      list_for_each_entry(p, &cfg->parm_list, next)
       {
-         return p;
+         if(strcmp(p->name, name) == 0)
+         {
+            return p;
+         }
       }
+      return NULL;
    }
-   return NULL;
+
+   n = lookupName(cfg, name);
+   if(n == NULL || list_empty(&n->params))
+   {
+      return NULL;
+   }
+   return list_first_entry(&n->params, ConfigParameter, same_name);
 }
 
 /**
@@ -335,6 +511,21 @@ ConfigParameter*
 lookupNextConfig(ConfigCB* cfg, ConfigParameter* current, char* name)
 {
    ConfigParameter* p = current;
+   ConfigName*      n;
+
+   //
+   // same name parameters are linked in parm_list order.
+   // just follow the link
+   //
+   if(!list_empty(&current->same_name) && strcmp(current->name, name) == 0)
+   {
+      n = lookupName(cfg, name);
+      if(n == NULL || list_is_last(&current->same_name, &n->params))
+      {
+         return NULL;
+      }
+      return list_entry(current->same_name.next, ConfigParameter, same_name);
+   }
 
    list_for_each_entry_continue(p, &cfg->parm_list, next)
    {
@@ -13,6 +13,7 @@
 
 #include <stdio.h>
 #include "list.h"
+#include "hash.h"
 
 /**
  * configuration parameter type
@@ -52,6 +53,7 @@ typedef struct _paramValue
 typedef struct
 {
    struct list_head  next;             /** a list used for linking config parameter values for a given configuration */
+   struct list_head  same_name;        /** a list of parameters with the same name in parm_list order */
    char              *name;            /** name of a config parameter */
    ParamValue        *val;             /** value of a config parameter */
 } ConfigParameter;
@@ -63,6 +65,8 @@ typedef struct
 {
    struct list_head  parm_list;        /** list head for a list of config parameters */
    int               numParams;        /** number of config parameters */
+   HashContext       name_index;       /** parameter names to parameters, built on first add */
+   int               index_failed;     /** name_index dropped on allocation failure, lookups scan parm_list */
 } ConfigCB;
 
 /**
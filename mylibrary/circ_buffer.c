@@ -12,6 +12,64 @@
 #include <stdlib.h>
 #include "circ_buffer.h"
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+
+//
+// free space seen by producer.
+// begin is reloaded only when cached copy says there is not enough room
+//
+static inline int
+get_free_size(CircBuffer* cb, int end, int size)
+{
+   int free_size;
+
+   free_size = cb->size - (end - cb->cached_begin + cb->capacity) % cb->capacity;
+   if(free_size < size)
+   {
+      cb->cached_begin = __atomic_load_n(&cb->begin, __ATOMIC_ACQUIRE);
+      free_size = cb->size - (end - cb->cached_begin + cb->capacity) % cb->capacity;
+   }
+   return free_size;
+}
+
+//
+// data size seen by consumer.
+// end is reloaded only when cached copy says there is not enough data
+//
+static inline int
+get_data_size(CircBuffer* cb, int begin, int size)
+{
+   int data_size;
+
+   data_size = (cb->cached_end - begin + cb->capacity) % cb->capacity;
+   if(data_size < size)
+   {
+      cb->cached_end = __atomic_load_n(&cb->end, __ATOMIC_ACQUIRE);
+      data_size = (cb->cached_end - begin + cb->capacity) % cb->capacity;
+   }
+   return data_size;
+}
+
+static inline void
+copy_from_circ_buffer(CircBuffer* cb, int begin, char* buf, int size)
+{
+   if(begin + size <= cb->capacity)
+   {
+      memcpy(buf, &cb->buffer[begin], size);
+   }
+   else
+   {
+      int begin_len = cb->capacity - begin;
+
+      memcpy(buf, &cb->buffer[begin], begin_len);
+      memcpy(&buf[begin_len], &cb->buffer[0], size - begin_len);
+   }
+}
+
 /*
  * initializes circular buffer
  * allocates a circular buffer of size "size"
@@ -25,17 +83,17 @@ init_circ_buffer(CircBuffer* cb, int size)
 {
    cb->buffer     = NULL;
    cb->size       = 0;
-   cb->begin      = 0;
-   cb->end        = 0;
-   cb->data_size  = 0;
+   cb->capacity   = 0;
+   reset_circ_buffer(cb);
 
-   cb->buffer = (char*)malloc(size);
+   cb->buffer = (char*)malloc(size + 1);
    if(cb->buffer == NULL)
    {
       return -1;
    }
 
    cb->size       = size;
+   cb->capacity   = size + 1;
    return 0;
 }
 
@@ -55,10 +113,49 @@ deinit_circ_buffer(CircBuffer* cb)
    }
 }
 
+/*
+ * allocates and initializes a circular buffer on heap
+ * CircBuffer needs CIRC_BUFFER_CACHE_LINE alignment, which malloc() doesn't
+ * guarantee. use this instead of malloc() with init_circ_buffer()
+ *
+ * @param size size of circular buffer
+ * @return circular buffer on success, NULL on fail
+ */
+CircBuffer*
+alloc_circ_buffer(int size)
+{
+   void* cb;
+
+   if(posix_memalign(&cb, CIRC_BUFFER_CACHE_LINE, sizeof(CircBuffer)) != 0)
+   {
+      return NULL;
+   }
+
+   if(init_circ_buffer((CircBuffer*)cb, size) != 0)
+   {
+      free(cb);
+      return NULL;
+   }
+   return (CircBuffer*)cb;
+}
+
+/*
+ * de-initializes and frees a circular buffer from alloc_circ_buffer()
+ *
+ * @param cb   circular buffer
+ */
+void
+free_circ_buffer(CircBuffer* cb)
+{
+   deinit_circ_buffer(cb);
+   free(cb);
+}
+
 /*
  * adds data to circular buffer
  * if the whole size data cannot be added to the circular buffer
  * error is returned
+ * this is the producer side of circular buffer
  *
  * @param cb   circular buffer
  * @param buf data buffer
@@ -68,25 +165,27 @@ deinit_circ_buffer(CircBuffer* cb)
 int
 put_circ_buffer(CircBuffer* cb, char* buf, int size)
 {
-   if(cb->data_size + size > cb->size)
+   int end = cb->end;
+
+   if(get_free_size(cb, end, size) < size)
    {
       return -1;
    }
 
-   if(cb->end + size > cb->size)
+   if(end + size > cb->capacity)
    {
-      int begin_len = cb->size - cb->end;
+      int begin_len = cb->capacity - end;
 
-      memcpy(&cb->buffer[cb->end], buf, begin_len);
+      memcpy(&cb->buffer[end], buf, begin_len);
       memcpy(&cb->buffer[0], &buf[begin_len], size - begin_len);
    }
    else
    {
-      memcpy(&cb->buffer[cb->end], buf, size);
+      memcpy(&cb->buffer[end], buf, size);
    }
 
-   cb->end = (cb->end  + size) % cb->size;
-   cb->data_size += size;
+   // publish data to consumer
+   __atomic_store_n(&cb->end, (end + size) % cb->capacity, __ATOMIC_RELEASE);
    return 0;
 }
 
@@ -94,6 +193,7 @@ put_circ_buffer(CircBuffer* cb, char* buf, int size)
  * removes data from circular buffer
  * if the whole size data cannot be removed from the circular buffer
  * error is returned
+ * this is the consumer side of circular buffer
  *
  * @param cb   circular buffer
  * @param buf buffer to copy data from circular buffer
@@ -103,25 +203,17 @@ put_circ_buffer(CircBuffer* cb, char* buf, int size)
 int
 get_circ_buffer(CircBuffer* cb, char* buf, int size)
 {
-   if(cb->data_size - size < 0)
+   int begin = cb->begin;
+
+   if(get_data_size(cb, begin, size) < size)
    {
       return -1;
    }
 
-   if(cb->begin + size <= cb->size)
-   {
-      memcpy(buf, &cb->buffer[cb->begin], size);
-   }
-   else
-   {
-      int begin_len = cb->size - cb->begin;
+   copy_from_circ_buffer(cb, begin, buf, size);
 
-      memcpy(buf, &cb->buffer[cb->begin], begin_len);
-      memcpy(&buf[begin_len], &cb->buffer[0], size - begin_len);
-   }
-
-   cb->begin = (cb->begin + size) % cb->size;
-   cb->data_size -= size;
+   // give space back to producer
+   __atomic_store_n(&cb->begin, (begin + size) % cb->capacity, __ATOMIC_RELEASE);
    return 0;
 }
 
@@ -130,6 +222,7 @@ get_circ_buffer(CircBuffer* cb, char* buf, int size)
  * user buffer
  * if the whole size data cannot be copied from the circular buffer
  * error is returned
+ * this is the consumer side of circular buffer
  *
  * @param cb   circular buffer
  * @param size size of data requested
@@ -138,13 +231,14 @@ get_circ_buffer(CircBuffer* cb, char* buf, int size)
 int
 get_circ_buffer_no_copy(CircBuffer* cb, int size)
 {
-   if(cb->data_size - size < 0)
+   int begin = cb->begin;
+
+   if(get_data_size(cb, begin, size) < size)
    {
       return -1;
    }
 
-   cb->begin = (cb->begin + size) % cb->size;
-   cb->data_size -= size;
+   __atomic_store_n(&cb->begin, (begin + size) % cb->capacity, __ATOMIC_RELEASE);
    return 0;
 }
 
@@ -152,6 +246,7 @@ get_circ_buffer_no_copy(CircBuffer* cb, int size)
  * gets data from circular but the data still remains in circular buffer
  * if the whole size data cannot be copied from the circular buffer
  * error is returned
+ * this is the consumer side of circular buffer
  *
  * @param cb circular buffer
  * @param buf user buffer to copy data to
@@ -161,21 +256,13 @@ get_circ_buffer_no_copy(CircBuffer* cb, int size)
 int
 peek_circ_buffer(CircBuffer* cb, char* buf, int size)
 {
-   if(cb->data_size - size < 0)
-   {
-      return -1;
-   }
+   int begin = cb->begin;
 
-   if(cb->begin + size <= cb->size)
+   if(get_data_size(cb, begin, size) < size)
    {
-      memcpy(buf, &cb->buffer[cb->begin], size);
+      return -1;
    }
-   else
-   {
-      int begin_len = cb->size - cb->begin;
 
-      memcpy(buf, &cb->buffer[cb->begin], begin_len);
-      memcpy(&buf[begin_len], &cb->buffer[0], size - begin_len);
-   }
+   copy_from_circ_buffer(cb, begin, buf, size);
    return 0;
 }
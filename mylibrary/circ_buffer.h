@@ -18,20 +18,39 @@
 #define FALSE        0
 #endif
 
+#define CIRC_BUFFER_CACHE_LINE      64
+
 /**
  * circular buffer structure
+ *
+ * a single producer calling put_circ_buffer() and a single consumer calling
+ * get_circ_buffer(), get_circ_buffer_no_copy() or peek_circ_buffer() can run
+ * concurrently without locks. begin is written only by the consumer and end
+ * only by the producer, each on its own cache line with a cached copy of the other.
+ * one extra byte is allocated to tell full from empty.
+ * the structure must be CIRC_BUFFER_CACHE_LINE aligned. static and automatic
+ * ones are aligned by compiler, but heap ones have to come from
+ * alloc_circ_buffer() or posix_memalign(), not malloc()
  */
 typedef struct
 {
    char*       buffer;        /** buffer pointer to store data    */
    int         size;          /** size of buffer                  */
-   int         data_size;     /** size of data in buffer          */
-   int         begin;         /** buffer begin index              */
-   int         end;           /** buffer end index                */
+   int         capacity;      /** allocated size, size + 1        */
+
+   /** consumer side */
+   int         begin __attribute__((aligned(CIRC_BUFFER_CACHE_LINE)));  /** buffer begin index  */
+   int         cached_end;    /** consumer's copy of end          */
+
+   /** producer side */
+   int         end __attribute__((aligned(CIRC_BUFFER_CACHE_LINE)));    /** buffer end index    */
+   int         cached_begin;  /** producer's copy of begin        */
 } CircBuffer;
 
 extern int init_circ_buffer(CircBuffer* cb, int size);
 extern void deinit_circ_buffer(CircBuffer* cb);
+extern CircBuffer* alloc_circ_buffer(int size);
+extern void free_circ_buffer(CircBuffer* cb);
 extern int put_circ_buffer(CircBuffer* cb, char* buf, int size);
 extern int get_circ_buffer(CircBuffer* cb, char* buf, int size);
 extern int peek_circ_buffer(CircBuffer* cb, char* buf, int size);
@@ -39,15 +58,17 @@ extern int get_circ_buffer_no_copy(CircBuffer* cb, int size);
 
 /*
  * reset circular buffer
+ * must not be called while producer or consumer is running
  *
  * @param cb   circular buffer
  */
 static inline void 
 reset_circ_buffer(CircBuffer* cb)
 {
-   cb->begin      = 0;
-   cb->end        = 0;
-   cb->data_size  = 0;
+   cb->begin         = 0;
+   cb->end           = 0;
+   cb->cached_begin  = 0;
+   cb->cached_end    = 0;
 }
 
 /*
@@ -59,7 +80,10 @@ reset_circ_buffer(CircBuffer* cb)
 static inline int
 get_circ_buffer_data_size(CircBuffer* cb)
 {
-   return cb->data_size;
+   int   begin = __atomic_load_n(&cb->begin, __ATOMIC_ACQUIRE),
+         end   = __atomic_load_n(&cb->end, __ATOMIC_ACQUIRE);
+
+   return (end - begin + cb->capacity) % cb->capacity;
 }
 
 /*
@@ -83,7 +107,7 @@ get_circ_buffer_size(CircBuffer* cb)
 static inline int
 is_circ_buffer_full(CircBuffer* cb)
 {
-   if(cb->data_size == cb->size)
+   if(get_circ_buffer_data_size(cb) == cb->size)
    {
       return TRUE;
    }
@@ -99,7 +123,7 @@ is_circ_buffer_full(CircBuffer* cb)
 static inline int
 is_circ_buffer_empty(CircBuffer* cb)
 {
-   if(cb->data_size == 0)
+   if(get_circ_buffer_data_size(cb) == 0)
    {
       return TRUE;
    }
@@ -0,0 +1,226 @@
+//
+// a sharded hash for concurrent access
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include <stdlib.h>
+#include <string.h>
+#include "concurrent_hash.h"
+
+#define CONCURRENT_HASH_MIN_BUCKETS    16
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// a shard is chosen by the high bits of a multiplicative hash,
+// so it doesn't correlate with the bucket a shard picks by modulo.
+// the hash value is passed down so that the shard doesn't hash the key again
+//
+static inline HashShard*
+getShard(ConcurrentHashContext* hash, void* key, unsigned int* hv)
+{
+   *hv = hash->calc_hash((unsigned char*)key, hash->key_size);
+
+   return &hash->shards[((*hv * 2654435769u) >> 16) & (hash->numShards - 1)];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * initialize a concurrent hash context
+ *
+ * @param hash concurrent hash context block
+ * @param numShards number of shards. rounded up to power of 2
+ * @param numBuckets total number of buckets, divided among shards
+ * @param hash_offset offset of hash element
+ * @param key_offset offset of hash key
+ * @param key_size size of hash key to use
+ * @param func hash function to use, use default if NULL
+ * @return 0 on success, -1 on failure
+ */
+int
+initConcurrentHash(ConcurrentHashContext* hash, int numShards, int numBuckets,
+      int hash_offset, int key_offset, int key_size, hash_func func)
+{
+   int   n = 1,
+         i;
+   void* shards;
+
+   while(n < numShards && n < CONCURRENT_HASH_MAX_SHARDS)
+   {
+      n *= 2;
+   }
+
+   numBuckets /= n;
+   if(numBuckets < CONCURRENT_HASH_MIN_BUCKETS)
+   {
+      numBuckets = CONCURRENT_HASH_MIN_BUCKETS;
+   }
+
+   if(posix_memalign(&shards, CONCURRENT_HASH_CACHE_LINE, sizeof(HashShard) * n) != 0)
+   {
+      return -1;
+   }
+
+   hash->numShards   = n;
+   hash->key_offset  = key_offset;
+   hash->key_size    = key_size;
+   hash->shards      = (HashShard*)shards;
+
+   for(i = 0; i < n; i++)
+   {
+      pthread_rwlock_init(&hash->shards[i].lock, NULL);
+      initHash(&hash->shards[i].hash, numBuckets, hash_offset, key_offset, key_size, func);
+   }
+
+   // use whatever the shards resolved func to
+   hash->calc_hash   = hash->shards[0].hash.calc_hash;
+   return 0;
+}
+
+/**
+ * deinitialize concurrent hash context block
+ * no thread should be accessing the hash
+ */
+void
+deinitConcurrentHash(ConcurrentHashContext* hash)
+{
+   int i;
+
+   for(i = 0; i < hash->numShards; i++)
+   {
+      deinitHash(&hash->shards[i].hash);
+      pthread_rwlock_destroy(&hash->shards[i].lock);
+   }
+
+   free(hash->shards);
+   hash->shards      = NULL;
+   hash->numShards   = 0;
+}
+
+/**
+ * add a new client element to concurrent hash
+ *
+ * @param hash concurrent hash context block
+ * @param element hash client element
+ * @return 0 on failure, 1 on success
+ */
+int
+addConcurrentHash(ConcurrentHashContext* hash, void* element)
+{
+   unsigned int   hv;
+   HashShard*     shard = getShard(hash, (char*)element + hash->key_offset, &hv);
+   int            ret;
+
+   pthread_rwlock_wrlock(&shard->lock);
+   ret = addHashWithValue(&shard->hash, element, hv);
+   pthread_rwlock_unlock(&shard->lock);
+
+   return ret;
+}
+
+/**
+ * lookup concurrent hash for a given key
+ * the element is returned after the shard is unlocked.
+ * caller has to make sure the element is not freed by other threads
+ * while using it. use visitConcurrentHash() otherwise
+ *
+ * @param hash concurrent hash context block
+ * @param key key to search with
+ * @return NULL when key is not found, pointer to client structure when found
+ */
+void*
+lookupConcurrentHash(ConcurrentHashContext* hash, void* key)
+{
+   unsigned int   hv;
+   HashShard*     shard = getShard(hash, key, &hv);
+   void*          element;
+
+   pthread_rwlock_rdlock(&shard->lock);
+   element = peekHashWithValue(&shard->hash, key, hv);
+   pthread_rwlock_unlock(&shard->lock);
+
+   return element;
+}
+
+/**
+ * lookup concurrent hash and call visitor with the element found
+ * while its shard is read locked. visitor must not modify the hash
+ *
+ * @param hash concurrent hash context block
+ * @param key key to search with
+ * @param visitor callback to call with the element found
+ * @param priv private argument for visitor
+ * @return 1 if found and visited, 0 if not found
+ */
+int
+visitConcurrentHash(ConcurrentHashContext* hash, void* key,
+      concurrent_hash_visitor visitor, void* priv)
+{
+   unsigned int   hv;
+   HashShard*     shard = getShard(hash, key, &hv);
+   void*          element;
+
+   pthread_rwlock_rdlock(&shard->lock);
+   element = peekHashWithValue(&shard->hash, key, hv);
+   if(element != NULL)
+   {
+      visitor(element, priv);
+   }
+   pthread_rwlock_unlock(&shard->lock);
+
+   return element != NULL;
+}
+
+/**
+ * delete a hash client element with given key from concurrent hash
+ *
+ * @param hash concurrent hash context block
+ * @param key hash key to search with
+ * @return element deleted, or NULL if not found
+ */
+void*
+delConcurrentHash(ConcurrentHashContext* hash, void* key)
+{
+   unsigned int   hv;
+   HashShard*     shard = getShard(hash, key, &hv);
+   void*          element;
+
+   pthread_rwlock_wrlock(&shard->lock);
+   element = removeHashWithValue(&shard->hash, key, hv);
+   pthread_rwlock_unlock(&shard->lock);
+
+   return element;
+}
+
+/**
+ * iterate over all the elements in concurrent hash
+ * each shard is read locked while being iterated.
+ * the iterator must not add or delete elements
+ *
+ * @param hash concurrent hash context block
+ * @param it iteration callback. called with the shard's HashContext
+ * @param priv private argument for iteration callback
+ */
+void
+iterateConcurrentHash(ConcurrentHashContext* hash, hash_iterator it, void* priv)
+{
+   int i;
+
+   for(i = 0; i < hash->numShards; i++)
+   {
+      pthread_rwlock_rdlock(&hash->shards[i].lock);
+      iterateHash(&hash->shards[i].hash, it, priv);
+      pthread_rwlock_unlock(&hash->shards[i].lock);
+   }
+}
@@ -0,0 +1,61 @@
+//
+// a sharded hash for concurrent access
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __CONCURRENT_HASH_DEF_H__
+#define __CONCURRENT_HASH_DEF_H__
+
+#include <pthread.h>
+#include "hash.h"
+
+#define CONCURRENT_HASH_CACHE_LINE     64
+#define CONCURRENT_HASH_MAX_SHARDS     65536
+
+/**
+ * a shard of concurrent hash
+ * each shard sits in its own cache lines so that locking a shard
+ * doesn't bounce the lock of its neighbor
+ */
+typedef struct hash_shard
+{
+   pthread_rwlock_t  lock;             /** readers share, writers exclude     */
+   HashContext       hash;             /** elements of this shard             */
+} __attribute__((aligned(CONCURRENT_HASH_CACHE_LINE))) HashShard;
+
+/**
+ * a concurrent hash context
+ *
+ * elements are partitioned into shards by hash value.
+ * each shard is an independently locked HashContext,
+ * so threads working on different shards never contend
+ */
+typedef struct concurrent_hash_context
+{
+   int               numShards;        /** number of shards, power of 2       */
+   int               key_offset;       /** hash key offset                    */
+   int               key_size;         /** hash key size                      */
+   hash_func         calc_hash;        /** hash function to use               */
+   HashShard*        shards;           /** shard array                        */
+} ConcurrentHashContext;
+
+/**
+ * called with an element while its shard is locked
+ */
+typedef void (*concurrent_hash_visitor)(void* element, void* priv);
+
+extern int initConcurrentHash(ConcurrentHashContext* hash, int numShards, int numBuckets,
+      int hash_offset, int key_offset, int key_size, hash_func func);
+extern void deinitConcurrentHash(ConcurrentHashContext* hash);
+extern int addConcurrentHash(ConcurrentHashContext* hash, void* element);
+extern void* lookupConcurrentHash(ConcurrentHashContext* hash, void* key);
+extern int visitConcurrentHash(ConcurrentHashContext* hash, void* key,
+      concurrent_hash_visitor visitor, void* priv);
+extern void* delConcurrentHash(ConcurrentHashContext* hash, void* key);
+extern void iterateConcurrentHash(ConcurrentHashContext* hash, hash_iterator it, void* priv);
+
+#endif //!__CONCURRENT_HASH_DEF_H__
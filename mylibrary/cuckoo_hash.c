@@ -0,0 +1,480 @@
+//
+// a bucketized cuckoo hash with bounded lookup
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include <stdlib.h>
+#include <string.h>
+#include "cuckoo_hash.h"
+#include "hash_func.h"
+
+#define CUCKOO_MIN_BUCKETS       2
+
+//
+// growing doesn't help when too many keys share a hash value.
+// give up after the table is this many times larger
+//
+#define CUCKOO_MAX_GROW_STEPS    3
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// both candidate buckets come from one hash value.
+// the second is the first xor'ed with another mix of the hash,
+// so either bucket can be computed from the other with the stored hash
+// value alone, without touching the element
+//
+static inline unsigned int
+getBucket1(CuckooHashContext* hash, unsigned int hv)
+{
+   return hv & (hash->numBuckets - 1);
+}
+
+static inline unsigned int
+getAltBucket(CuckooHashContext* hash, unsigned int ndx, unsigned int hv)
+{
+   return (ndx ^ ((hv * 0x5bd1e995) >> 7)) & (hash->numBuckets - 1);
+}
+
+static inline void*
+getElementKey(CuckooHashContext* hash, void* element)
+{
+   return (char*)element + hash->key_offset;
+}
+
+static inline int
+matchSlot(CuckooHashContext* hash, CuckooBucket* b, int i, void* key, unsigned int hv)
+{
+   return b->slot[i] != NULL && b->hv[i] == hv &&
+          memcmp(key, getElementKey(hash, b->slot[i]), hash->key_size) == 0;
+}
+
+//
+// finds where an element is. returns its bucket and slot,
+// or bucket -1 and stash index in slot
+//
+static int
+findCuckooHash(CuckooHashContext* hash, void* key, unsigned int hv, int* slot)
+{
+   unsigned int   b1 = getBucket1(hash, hv),
+                  b2 = getAltBucket(hash, b1, hv);
+   int            i;
+
+   for(i = 0; i < CUCKOO_SLOTS_PER_BUCKET; i++)
+   {
+      if(matchSlot(hash, &hash->buckets[b1], i, key, hv))
+      {
+         *slot = i;
+         return b1;
+      }
+   }
+
+   for(i = 0; i < CUCKOO_SLOTS_PER_BUCKET; i++)
+   {
+      if(matchSlot(hash, &hash->buckets[b2], i, key, hv))
+      {
+         *slot = i;
+         return b2;
+      }
+   }
+
+   for(i = 0; i < hash->numStash; i++)
+   {
+      if(hash->stashHv[i] == hv &&
+         memcmp(key, getElementKey(hash, hash->stash[i]), hash->key_size) == 0)
+      {
+         *slot = i;
+         return -1;
+      }
+   }
+
+   *slot = -1;
+   return -1;
+}
+
+static int
+putToBucket(CuckooBucket* b, void* element, unsigned int hv)
+{
+   int i;
+
+   for(i = 0; i < CUCKOO_SLOTS_PER_BUCKET; i++)
+   {
+      if(b->slot[i] == NULL)
+      {
+         b->slot[i]  = element;
+         b->hv[i]    = hv;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+//
+// places an element into one of its buckets, kicking out residents
+// to their alternate buckets when needed. if it runs out of kicks,
+// the element left homeless goes to stash.
+// returns 0 only when stash is full too, with *homeless set
+//
+static int
+placeElement(CuckooHashContext* hash, void* element, unsigned int hv,
+      void** homeless, unsigned int* homelessHv)
+{
+   unsigned int   ndx = getBucket1(hash, hv),
+                  alt;
+   int            kick,
+                  victim;
+   void*          tmp;
+   unsigned int   tmpHv;
+
+   if(putToBucket(&hash->buckets[ndx], element, hv))
+   {
+      return 1;
+   }
+
+   ndx = getAltBucket(hash, ndx, hv);
+   if(putToBucket(&hash->buckets[ndx], element, hv))
+   {
+      return 1;
+   }
+
+   for(kick = 0; kick < CUCKOO_MAX_KICKS; kick++)
+   {
+      CuckooBucket* b = &hash->buckets[ndx];
+
+      hash->seed  = hash->seed * 1103515245 + 12345;
+      victim      = (hash->seed >> 16) % CUCKOO_SLOTS_PER_BUCKET;
+
+      tmp               = b->slot[victim];
+      tmpHv             = b->hv[victim];
+      b->slot[victim]   = element;
+      b->hv[victim]     = hv;
+
+      element  = tmp;
+      hv       = tmpHv;
+      alt      = getAltBucket(hash, ndx, hv);
+
+      if(putToBucket(&hash->buckets[alt], element, hv))
+      {
+         return 1;
+      }
+      ndx = alt;
+   }
+
+   if(hash->numStash < CUCKOO_STASH_SIZE)
+   {
+      hash->stash[hash->numStash]   = element;
+      hash->stashHv[hash->numStash] = hv;
+      hash->numStash++;
+      return 1;
+   }
+
+   *homeless   = element;
+   *homelessHv = hv;
+   return 0;
+}
+
+static CuckooBucket*
+allocBuckets(int numBuckets)
+{
+   void* buckets;
+
+   if(posix_memalign(&buckets, sizeof(CuckooBucket), sizeof(CuckooBucket) * numBuckets) != 0)
+   {
+      return NULL;
+   }
+
+   memset(buckets, 0, sizeof(CuckooBucket) * numBuckets);
+   return (CuckooBucket*)buckets;
+}
+
+//
+// doubles the buckets and places all the elements again,
+// with an extra element that found no place.
+// the table is left as it was on failure
+//
+static int
+growCuckooHash(CuckooHashContext* hash, void* extra, unsigned int extraHv)
+{
+   CuckooBucket*  old = hash->buckets;
+   int            oldNumBuckets = hash->numBuckets,
+                  oldNumStash = hash->numStash,
+                  numBuckets = oldNumBuckets * 2,
+                  steps = 0,
+                  i, j;
+   void*          stash[CUCKOO_STASH_SIZE + 1];
+   unsigned int   stashHv[CUCKOO_STASH_SIZE + 1];
+   void*          homeless;
+   unsigned int   homelessHv;
+
+   memcpy(stash, hash->stash, sizeof(void*) * oldNumStash);
+   memcpy(stashHv, hash->stashHv, sizeof(unsigned int) * oldNumStash);
+   stash[oldNumStash]   = extra;
+   stashHv[oldNumStash] = extraHv;
+
+   while(1)
+   {
+      hash->buckets = ++steps <= CUCKOO_MAX_GROW_STEPS ? allocBuckets(numBuckets) : NULL;
+      if(hash->buckets == NULL)
+      {
+         hash->buckets     = old;
+         hash->numBuckets  = oldNumBuckets;
+         hash->numStash    = oldNumStash;
+         memcpy(hash->stash, stash, sizeof(void*) * oldNumStash);
+         memcpy(hash->stashHv, stashHv, sizeof(unsigned int) * oldNumStash);
+         return -1;
+      }
+      hash->numBuckets  = numBuckets;
+      hash->numStash    = 0;
+
+      for(i = 0; i < oldNumBuckets; i++)
+      {
+         for(j = 0; j < CUCKOO_SLOTS_PER_BUCKET; j++)
+         {
+            if(old[i].slot[j] != NULL &&
+               !placeElement(hash, old[i].slot[j], old[i].hv[j], &homeless, &homelessHv))
+            {
+               goto retry;
+            }
+         }
+      }
+
+      for(i = 0; i <= oldNumStash; i++)
+      {
+         if(!placeElement(hash, stash[i], stashHv[i], &homeless, &homelessHv))
+         {
+            goto retry;
+         }
+      }
+
+      free(old);
+      return 0;
+
+retry:
+      // very unlikely. try with even more buckets
+      free(hash->buckets);
+      numBuckets *= 2;
+   }
+}
+
+//
+// a stashed element may fit in its bucket once something is deleted
+//
+static void
+drainStash(CuckooHashContext* hash)
+{
+   int            i = 0;
+   unsigned int   b1;
+
+   while(i < hash->numStash)
+   {
+      b1 = getBucket1(hash, hash->stashHv[i]);
+
+      if(putToBucket(&hash->buckets[b1], hash->stash[i], hash->stashHv[i]) ||
+         putToBucket(&hash->buckets[getAltBucket(hash, b1, hash->stashHv[i])],
+            hash->stash[i], hash->stashHv[i]))
+      {
+         hash->numStash--;
+         hash->stash[i]    = hash->stash[hash->numStash];
+         hash->stashHv[i]  = hash->stashHv[hash->numStash];
+         continue;
+      }
+      i++;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * initialize a cuckoo hash context
+ *
+ * @param hash cuckoo hash context block
+ * @param numElements expected number of elements
+ * @param key_offset offset of hash key
+ * @param key_size size of hash key to use
+ * @param func hash function to use, wy_hash if NULL
+ * @return 0 on success, -1 on memory allocation failure
+ */
+int
+initCuckooHash(CuckooHashContext* hash, int numElements,
+      int key_offset, int key_size, hash_func func)
+{
+   int n = CUCKOO_MIN_BUCKETS;
+
+   // aim at about 50% load
+   while(n * CUCKOO_SLOTS_PER_BUCKET < numElements * 2)
+   {
+      n *= 2;
+   }
+
+   hash->buckets = allocBuckets(n);
+   if(hash->buckets == NULL)
+   {
+      return -1;
+   }
+
+   hash->numBuckets     = n;
+   hash->key_offset     = key_offset;
+   hash->key_size       = key_size;
+   hash->calc_hash      = func != NULL ? func : wy_hash;
+   hash->numElements    = 0;
+   hash->numStash       = 0;
+   hash->seed           = 1;
+   return 0;
+}
+
+/**
+ * deinitialize cuckoo hash context block
+ */
+void
+deinitCuckooHash(CuckooHashContext* hash)
+{
+   free(hash->buckets);
+   hash->buckets = NULL;
+}
+
+/**
+ * lookup cuckoo hash for a given key
+ * at most two buckets and the stash are examined
+ *
+ * @param hash cuckoo hash context block
+ * @param key key to search with
+ * @return NULL when key is not found, pointer to client structure when found
+ */
+void*
+lookupCuckooHash(CuckooHashContext* hash, void* key)
+{
+   int b, slot;
+
+   b = findCuckooHash(hash, key, hash->calc_hash(key, hash->key_size), &slot);
+   if(b >= 0)
+   {
+      return hash->buckets[b].slot[slot];
+   }
+   return slot >= 0 ? hash->stash[slot] : NULL;
+}
+
+/**
+ * add a new client element to cuckoo hash
+ *
+ * @param hash cuckoo hash context block
+ * @param element hash client element
+ * @return 0 on failure, 1 on success
+ */
+int
+addCuckooHash(CuckooHashContext* hash, void* element)
+{
+   void*          key = getElementKey(hash, element);
+   unsigned int   hv = hash->calc_hash(key, hash->key_size),
+                  homelessHv;
+   void*          homeless;
+   int            b,
+                  slot;
+
+   if(findCuckooHash(hash, key, hv, &slot) >= 0 || slot >= 0)
+   {
+      return 0;
+   }
+
+   if(placeElement(hash, element, hv, &homeless, &homelessHv) ||
+      growCuckooHash(hash, homeless, homelessHv) == 0)
+   {
+      hash->numElements++;
+      return 1;
+   }
+
+   //
+   // out of memory. the element left out may be an old one
+   // kicked out by the new one. put it back in place of the new one
+   //
+   if(homeless != element)
+   {
+      b = findCuckooHash(hash, key, hv, &slot);
+      if(b >= 0)
+      {
+         hash->buckets[b].slot[slot]   = homeless;
+         hash->buckets[b].hv[slot]     = homelessHv;
+      }
+      else
+      {
+         hash->stash[slot]    = homeless;
+         hash->stashHv[slot]  = homelessHv;
+      }
+   }
+   return 0;
+}
+
+/**
+ * delete a hash client element with given key from cuckoo hash context
+ *
+ * @param hash cuckoo hash context block
+ * @param key hash key to search with
+ * @return 1 on success, 0 on failure
+ */
+int
+delCuckooHash(CuckooHashContext* hash, void* key)
+{
+   int b, slot;
+
+   b = findCuckooHash(hash, key, hash->calc_hash(key, hash->key_size), &slot);
+   if(b >= 0)
+   {
+      hash->buckets[b].slot[slot] = NULL;
+      if(hash->numStash > 0)
+      {
+         drainStash(hash);
+      }
+   }
+   else if(slot >= 0)
+   {
+      hash->numStash--;
+      hash->stash[slot]    = hash->stash[hash->numStash];
+      hash->stashHv[slot]  = hash->stashHv[hash->numStash];
+   }
+   else
+   {
+      return 0;
+   }
+
+   hash->numElements--;
+   return 1;
+}
+
+/**
+ * iterate over all the elements in cuckoo hash
+ * the iterator must not add or delete elements
+ *
+ * @param hash cuckoo hash context block
+ * @param it iteration callback
+ * @param priv private argument for iteration callback
+ */
+void
+iterateCuckooHash(CuckooHashContext* hash, cuckoo_hash_iterator it, void* priv)
+{
+   int i, j;
+
+   for(i = 0; i < hash->numBuckets; i++)
+   {
+      for(j = 0; j < CUCKOO_SLOTS_PER_BUCKET; j++)
+      {
+         if(hash->buckets[i].slot[j] != NULL)
+         {
+            it(hash, hash->buckets[i].slot[j], priv);
+         }
+      }
+   }
+
+   for(i = 0; i < hash->numStash; i++)
+   {
+      it(hash, hash->stash[i], priv);
+   }
+}
@@ -0,0 +1,64 @@
+//
+// a bucketized cuckoo hash with bounded lookup
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __CUCKOO_HASH_DEF_H__
+#define __CUCKOO_HASH_DEF_H__
+
+#include "hash.h"
+
+#define CUCKOO_SLOTS_PER_BUCKET  4
+#define CUCKOO_STASH_SIZE        8
+#define CUCKOO_MAX_KICKS         256
+
+/**
+ * a cuckoo bucket, one cache line
+ */
+typedef struct cuckoo_bucket
+{
+   unsigned int      hv[CUCKOO_SLOTS_PER_BUCKET];     /** hash value of elements */
+   void*             slot[CUCKOO_SLOTS_PER_BUCKET];   /** elements, NULL if empty */
+} __attribute__((aligned(64))) CuckooBucket;
+
+/**
+ * a cuckoo hash context
+ *
+ * an element lives in one of two candidate buckets or in a small stash,
+ * so a lookup checks at most two buckets plus the stash no matter how
+ * keys are distributed. when both buckets are full, insertion moves
+ * existing elements to their alternate bucket up to CUCKOO_MAX_KICKS times.
+ * elements are not intrusive. the table keeps pointers to client elements
+ */
+typedef struct cuckoo_hash_context
+{
+   int               numBuckets;       /** number of buckets, power of 2      */
+   int               key_offset;       /** hash key offset                    */
+   int               key_size;         /** hash key size                      */
+   hash_func         calc_hash;        /** hash function to use               */
+   CuckooBucket*     buckets;          /** bucket array                       */
+   int               numElements;      /** number of elements in hash         */
+   int               numStash;         /** number of elements in stash        */
+   unsigned int      stashHv[CUCKOO_STASH_SIZE];   /** hash value of stashed elements */
+   void*             stash[CUCKOO_STASH_SIZE];     /** elements that found no bucket  */
+   unsigned int      seed;             /** random state for victim selection  */
+} CuckooHashContext;
+
+/**
+ * cuckoo hash iteration callback
+ */
+typedef void (*cuckoo_hash_iterator)(CuckooHashContext* hash, void* element, void* priv);
+
+extern int initCuckooHash(CuckooHashContext* hash, int numElements,
+      int key_offset, int key_size, hash_func func);
+extern void deinitCuckooHash(CuckooHashContext* hash);
+extern int addCuckooHash(CuckooHashContext* hash, void* element);
+extern void* lookupCuckooHash(CuckooHashContext* hash, void* key);
+extern int delCuckooHash(CuckooHashContext* hash, void* key);
+extern void iterateCuckooHash(CuckooHashContext* hash, cuckoo_hash_iterator it, void* priv);
+
+#endif //!__CUCKOO_HASH_DEF_H__
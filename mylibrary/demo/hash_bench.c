@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "hash.h"
+#include "swiss_hash.h"
+#include "cuckoo_hash.h"
+#include "hash_snapshot.h"
+
+//
+// compares lookup throughput of chained hash, with and without
+// a bloom filter, swiss hash, cuckoo hash and a mapped snapshot
+// with session table like 16 byte keys
+//
+
+typedef struct
+{
+   unsigned int      src_ip;
+   unsigned int      dst_ip;
+   unsigned short    src_port;
+   unsigned short    dst_port;
+   unsigned int      proto;
+} SessionKey;
+
+typedef struct
+{
+   HashElement       elem;
+   SessionKey        key;
+   int               data;
+} Session;
+
+#define DEFAULT_NUM_SESSIONS     (1024 * 1024)
+#define NUM_LOOKUPS              (8 * 1024 * 1024)
+#define LOOKUP_BATCH             32
+#define SNAPSHOT_PATH            "/tmp/hash_bench.snapshot"
+
+static Session*      sessions;
+static SessionKey*   keys;
+static int           num_sessions = DEFAULT_NUM_SESSIONS;
+
+static double
+now_sec(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+make_key(SessionKey* key, int i)
+{
+   memset(key, 0, sizeof(SessionKey));
+   key->src_ip    = 0x0a000000 | (i >> 4);
+   key->dst_ip    = 0xc0a80001;
+   key->src_port  = 1024 + (i & 0xf);
+   key->dst_port  = 80;
+   key->proto     = 6;
+}
+
+//
+// half the lookups hit, half miss
+//
+static void
+make_lookup_keys(void)
+{
+   int i;
+
+   keys = (SessionKey*)malloc(sizeof(SessionKey) * NUM_LOOKUPS);
+   for(i = 0; i < NUM_LOOKUPS; i++)
+   {
+      int n = rand() % num_sessions;
+
+      make_key(&keys[i], (i & 1) ? n : n + num_sessions);
+   }
+}
+
+static void
+bench_chained(void)
+{
+   HashContext hash;
+   BloomFilter bloom;
+   double      start;
+   int         i,
+               found = 0;
+
+   initHash(&hash, num_sessions, offsetof(Session, elem),
+         offsetof(Session, key), sizeof(SessionKey), NULL);
+
+   start = now_sec();
+   for(i = 0; i < num_sessions; i++)
+   {
+      addHash(&hash, &sessions[i]);
+   }
+   printf("chained hash : insert %7.2f Mops/s, ", num_sessions / (now_sec() - start) / 1e6);
+
+   start = now_sec();
+   for(i = 0; i < NUM_LOOKUPS; i++)
+   {
+      if(lookupHash(&hash, &keys[i]) != NULL)
+      {
+         found++;
+      }
+   }
+   printf("lookup %7.2f Mops/s (%d found)\n", NUM_LOOKUPS / (now_sec() - start) / 1e6, found);
+
+   found = 0;
+   start = now_sec();
+   for(i = 0; i < NUM_LOOKUPS; i += LOOKUP_BATCH)
+   {
+      void* batch_keys[LOOKUP_BATCH];
+      void* batch_out[LOOKUP_BATCH];
+      int   j;
+
+      for(j = 0; j < LOOKUP_BATCH; j++)
+      {
+         batch_keys[j] = &keys[i + j];
+      }
+      found += lookupHashBatch(&hash, batch_keys, LOOKUP_BATCH, batch_out);
+   }
+   printf("chained hash : batch of %d lookup %7.2f Mops/s (%d found)\n",
+         LOOKUP_BATCH, NUM_LOOKUPS / (now_sec() - start) / 1e6, found);
+
+   // misses are rejected by the filter without walking a chain
+   if(initBloomFilter(&bloom, num_sessions, BLOOM_DEFAULT_BITS, 0) == 0)
+   {
+      attachHashBloomFilter(&hash, &bloom);
+
+      found = 0;
+      start = now_sec();
+      for(i = 0; i < NUM_LOOKUPS; i++)
+      {
+         if(lookupHash(&hash, &keys[i]) != NULL)
+         {
+            found++;
+         }
+      }
+      printf("chained hash : bloom filtered lookup %7.2f Mops/s (%d found)\n",
+            NUM_LOOKUPS / (now_sec() - start) / 1e6, found);
+
+      attachHashBloomFilter(&hash, NULL);
+      deinitBloomFilter(&bloom);
+   }
+
+   deinitHash(&hash);
+}
+
+static void
+bench_swiss(void)
+{
+   SwissHashContext  hash;
+   double            start;
+   int               i,
+                     found = 0;
+
+   initSwissHash(&hash, num_sessions, offsetof(Session, key), sizeof(SessionKey), NULL);
+
+   start = now_sec();
+   for(i = 0; i < num_sessions; i++)
+   {
+      addSwissHash(&hash, &sessions[i]);
+   }
+   printf("swiss hash   : insert %7.2f Mops/s, ", num_sessions / (now_sec() - start) / 1e6);
+
+   start = now_sec();
+   for(i = 0; i < NUM_LOOKUPS; i++)
+   {
+      if(lookupSwissHash(&hash, &keys[i]) != NULL)
+      {
+         found++;
+      }
+   }
+   printf("lookup %7.2f Mops/s (%d found)\n", NUM_LOOKUPS / (now_sec() - start) / 1e6, found);
+
+   deinitSwissHash(&hash);
+}
+
+static void
+bench_cuckoo(void)
+{
+   CuckooHashContext hash;
+   double            start;
+   int               i,
+                     found = 0;
+
+   initCuckooHash(&hash, num_sessions, offsetof(Session, key), sizeof(SessionKey), NULL);
+
+   start = now_sec();
+   for(i = 0; i < num_sessions; i++)
+   {
+      addCuckooHash(&hash, &sessions[i]);
+   }
+   printf("cuckoo hash  : insert %7.2f Mops/s, ", num_sessions / (now_sec() - start) / 1e6);
+
+   start = now_sec();
+   for(i = 0; i < NUM_LOOKUPS; i++)
+   {
+      if(lookupCuckooHash(&hash, &keys[i]) != NULL)
+      {
+         found++;
+      }
+   }
+   printf("lookup %7.2f Mops/s (%d found)\n", NUM_LOOKUPS / (now_sec() - start) / 1e6, found);
+
+   deinitCuckooHash(&hash);
+}
+
+//
+// startup from a saved image instead of adding all the sessions again
+//
+static void
+bench_snapshot(void)
+{
+   HashContext    hash;
+   HashSnapshot   snap;
+   double         start;
+   int            i,
+                  found = 0;
+
+   initHash(&hash, num_sessions, offsetof(Session, elem),
+         offsetof(Session, key), sizeof(SessionKey), NULL);
+   for(i = 0; i < num_sessions; i++)
+   {
+      addHash(&hash, &sessions[i]);
+   }
+
+   start = now_sec();
+   if(saveHashSnapshot(&hash, sizeof(Session), SNAPSHOT_PATH) != 0)
+   {
+      printf("snapshot     : failed to save %s\n", SNAPSHOT_PATH);
+      deinitHash(&hash);
+      return;
+   }
+   printf("snapshot     : save %7.2f ms, ", (now_sec() - start) * 1e3);
+   deinitHash(&hash);
+
+   start = now_sec();
+   if(openHashSnapshot(&snap, SNAPSHOT_PATH, NULL) != 0)
+   {
+      printf("failed to open\n");
+      unlink(SNAPSHOT_PATH);
+      return;
+   }
+   printf("open %7.2f ms, ", (now_sec() - start) * 1e3);
+
+   start = now_sec();
+   for(i = 0; i < NUM_LOOKUPS; i++)
+   {
+      if(lookupHashSnapshot(&snap, &keys[i]) != NULL)
+      {
+         found++;
+      }
+   }
+   printf("lookup %7.2f Mops/s (%d found)\n", NUM_LOOKUPS / (now_sec() - start) / 1e6, found);
+
+   closeHashSnapshot(&snap);
+   unlink(SNAPSHOT_PATH);
+}
+
+int
+main(int argc, char** argv)
+{
+   int i;
+
+   if(argc > 1)
+   {
+      num_sessions = atoi(argv[1]);
+   }
+
+   sessions = (Session*)malloc(sizeof(Session) * num_sessions);
+   for(i = 0; i < num_sessions; i++)
+   {
+      make_key(&sessions[i].key, i);
+      sessions[i].data = i;
+   }
+   make_lookup_keys();
+
+   printf("%d sessions, %d lookups\n", num_sessions, NUM_LOOKUPS);
+   bench_chained();
+   bench_swiss();
+   bench_cuckoo();
+   bench_snapshot();
+
+   free(keys);
+   free(sessions);
+   return 0;
+}
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_func.h"
+
+//
+// measures hash function throughput for various key sizes
+// and bucket chain length distribution for typical key sets
+//
+
+#define NUM_KEYS           (64 * 1024)
+#define NUM_BUCKETS        (64 * 1024)
+#define MAX_KEY_SIZE       256
+#define BYTES_PER_RUN      (256 * 1024 * 1024)
+#define MAX_CHAIN_HIST     8
+
+static const char* funcNames[] = { "djb", "fnv1a", "wyhash", "crc32c" };
+
+#define NUM_FUNCS          (sizeof(funcNames) / sizeof(funcNames[0]))
+
+static int keySizes[] = { 4, 8, 16, 32, 64, 256 };
+
+#define NUM_KEY_SIZES      (sizeof(keySizes) / sizeof(keySizes[0]))
+
+static unsigned char keyBuf[NUM_KEYS * MAX_KEY_SIZE];
+static int           chains[NUM_BUCKETS];
+
+static double
+now_sec(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_throughput(void)
+{
+   int            f, k, i,
+                  n;
+   unsigned int   sum = 0;
+   double         start, elapsed;
+   hash_func      func;
+
+   printf("%-8s", "size");
+   for(f = 0; f < NUM_FUNCS; f++)
+   {
+      printf("%18s", funcNames[f]);
+   }
+   printf("\n");
+
+   for(k = 0; k < NUM_KEY_SIZES; k++)
+   {
+      printf("%-8d", keySizes[k]);
+
+      n = BYTES_PER_RUN / keySizes[k];
+      for(f = 0; f < NUM_FUNCS; f++)
+      {
+         func = lookupHashFunc(funcNames[f]);
+
+         start = now_sec();
+         for(i = 0; i < n; i++)
+         {
+            sum += func(&keyBuf[(i % NUM_KEYS) * keySizes[k]], keySizes[k]);
+         }
+         elapsed = now_sec() - start;
+
+         printf("%9.0f MB/s %3.0fns", BYTES_PER_RUN / elapsed / 1e6, elapsed / n * 1e9);
+      }
+      printf("\n");
+   }
+   printf("(checksum %u)\n\n", sum);
+}
+
+static void
+print_chains(const char* name, hash_func func, int key_size)
+{
+   int   i,
+         max = 0,
+         hist[MAX_CHAIN_HIST + 1];
+   long  probes = 0;
+
+   memset(chains, 0, sizeof(chains));
+   memset(hist, 0, sizeof(hist));
+
+   for(i = 0; i < NUM_KEYS; i++)
+   {
+      chains[func(&keyBuf[i * key_size], key_size) % NUM_BUCKETS]++;
+   }
+
+   for(i = 0; i < NUM_BUCKETS; i++)
+   {
+      hist[chains[i] < MAX_CHAIN_HIST ? chains[i] : MAX_CHAIN_HIST]++;
+      if(chains[i] > max)
+      {
+         max = chains[i];
+      }
+      // a hit walks half the chain on average
+      probes += (long)chains[i] * (chains[i] + 1) / 2;
+   }
+
+   printf("  %-8s max %4d avg probe %5.2f  ", name, max, (double)probes / NUM_KEYS);
+   for(i = 0; i <= MAX_CHAIN_HIST; i++)
+   {
+      printf(" %6d", hist[i]);
+   }
+   printf("\n");
+}
+
+static void
+bench_chains(const char* desc, int key_size)
+{
+   int f;
+
+   printf("%s, %d keys, %d buckets. histogram of chain length 0..%d+\n",
+         desc, NUM_KEYS, NUM_BUCKETS, MAX_CHAIN_HIST);
+   for(f = 0; f < NUM_FUNCS; f++)
+   {
+      print_chains(funcNames[f], lookupHashFunc(funcNames[f]), key_size);
+   }
+   printf("\n");
+}
+
+//
+// 16 byte session keys. sequential source address and port
+//
+static void
+make_session_keys(void)
+{
+   int i;
+
+   memset(keyBuf, 0, sizeof(keyBuf));
+   for(i = 0; i < NUM_KEYS; i++)
+   {
+      unsigned char* k = &keyBuf[i * 16];
+      unsigned int   ip = 0x0a000000 | (i >> 4);
+      unsigned short port = 1024 + (i & 0xf);
+
+      memcpy(k, &ip, 4);
+      k[4] = 192; k[5] = 168; k[6] = 0; k[7] = 1;
+      memcpy(k + 8, &port, 2);
+      k[10] = 0; k[11] = 80;
+      k[12] = 6;
+   }
+}
+
+//
+// 32 byte NUL padded configuration names
+//
+static void
+make_name_keys(void)
+{
+   int i;
+
+   memset(keyBuf, 0, sizeof(keyBuf));
+   for(i = 0; i < NUM_KEYS; i++)
+   {
+      snprintf((char*)&keyBuf[i * 32], 32, "module.param_%d", i);
+   }
+}
+
+//
+// 4 byte integers in stride of 1024
+//
+static void
+make_int_keys(void)
+{
+   int i;
+
+   memset(keyBuf, 0, sizeof(keyBuf));
+   for(i = 0; i < NUM_KEYS; i++)
+   {
+      unsigned int v = i * 1024;
+
+      memcpy(&keyBuf[i * 4], &v, 4);
+   }
+}
+
+int
+main(int argc, char** argv)
+{
+   int i;
+
+   for(i = 0; i < sizeof(keyBuf); i++)
+   {
+      keyBuf[i] = rand();
+   }
+
+   printf("hardware crc32c: %s\n\n", hasHardwareCrc32c() ? "yes" : "no");
+   bench_throughput();
+
+   make_session_keys();
+   bench_chains("session keys", 16);
+
+   make_name_keys();
+   bench_chains("name keys", 32);
+
+   make_int_keys();
+   bench_chains("integer keys", 4);
+
+   return 0;
+}
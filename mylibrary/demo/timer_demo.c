@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "timer.h"
+
+//
+// checks get_timer_timeout() against the time actually left for a timer
+// while the wheel goes across a level 0 wrap around.
+// instead of sleeping, the previous drive time is moved back as if
+// the event loop had been blocked for that long.
+// waking up early is fine, e.g. hierarchical wheel wakes up at wrap around
+// to cascade, but a timeout past the expiry delays the timer
+//
+#define DEMO_EXPIRES       300
+#define DEMO_TOLERANCE     2
+
+static int num_fired = 0;
+
+static void
+demo_timer_cb(TimerElem* elem)
+{
+   num_fired++;
+}
+
+static void
+pretend_elapsed(Timer* timer, int msec)
+{
+   timer->prev -= msec * 1000000ULL;
+}
+
+static int
+check_timeout_across_wrap(TimerMode mode, const char* name)
+{
+   Timer       timer;
+   TimerElem   elem;
+   int         elapsed,
+               timeout,
+               expected,
+               errors = 0;
+
+   for(elapsed = 240; elapsed < 280; elapsed++)
+   {
+      if(init_timer_mode(&timer, 1, 1024, mode) != 0)
+      {
+         printf("%s: init_timer_mode failed\n", name);
+         return 1;
+      }
+
+      init_timer_elem(&elem);
+      elem.cb = demo_timer_cb;
+      add_timer(&timer, &elem, DEMO_EXPIRES);
+
+      pretend_elapsed(&timer, elapsed);
+      drive_timer(&timer);
+
+      timeout  = get_timer_timeout(&timer, -1);
+      expected = DEMO_EXPIRES - elapsed;
+
+      if(timeout < 0 || timeout > expected + DEMO_TOLERANCE)
+      {
+         printf("%s: tick %u, %d msec elapsed, timeout %d, expected %d\n",
+               name, timer.tick, elapsed, timeout, expected);
+         errors++;
+      }
+
+      if(is_timer_running(&elem))
+      {
+         del_timer(&timer, &elem);
+      }
+      deinit_timer(&timer);
+   }
+
+   printf("%-16s %s\n", name, errors == 0 ? "ok" : "FAILED");
+   return errors;
+}
+
+int
+main(int argc, char** argv)
+{
+   int errors = 0;
+
+   errors += check_timeout_across_wrap(TIMER_MODE_WHEEL, "wheel");
+   errors += check_timeout_across_wrap(TIMER_MODE_HIERARCHICAL, "hierarchical");
+
+   return errors == 0 ? 0 : 1;
+}
@@ -8,53 +8,294 @@
 //
 //
 #include "hash.h"
+#include "hash_func.h"
 #include <stdlib.h>
 #include <string.h>
 
-static unsigned int 
-djb_hash(unsigned char *key, int len )
+//
+// number of buckets moved per hash operation while rehashing
+// and how many empty buckets can be skipped over in a step
+//
+#define HASH_REHASH_STEP         1
+#define HASH_REHASH_EMPTY_VISITS 16
+
+//
+// number of keys processed together by lookupHashBatch()
+//
+#define HASH_BATCH_SIZE          64
+
+//
+// chain length histogram range for printHashStat()
+//
+#define HASH_STAT_MAX_CHAIN      8
+
+static inline struct list_head*
+getElementLH(HashContext* hash, void* element)
 {
-   unsigned h = 0;
-   int i;
-   
-   for( i = 0; i < len; i++ )
+   return (struct list_head*)((char*)element + hash->offset);
+}
+
+static inline void*
+getElement(HashContext* hash, struct list_head* lh)
+{
+   return (char*)lh - hash->offset;
+}
+
+static inline void*
+getKeyFromElement(HashContext* hash, void* element)
+{
+   char* key = (char*)element + hash->key_offset;
+
+   if(hash->key_flags & HASH_KEY_INDIRECT)
    {
-      h = 33 * h ^ key[i];
+      return *(char**)key;
    }
-   return h;
+   return key;
 }
 
+static inline void*
+getElementKey(HashContext* hash, struct list_head* lh)
+{
+   return getKeyFromElement(hash, getElement(hash, lh));
+}
 
-#if 0
-static unsigned int
-calc_hash(unsigned char* key, int key_size)
+static inline int
+getKeyLen(HashContext* hash, void* key)
 {
-   unsigned char *p = key;
-   unsigned h = 0, g;
-   int i;
-   
-   for ( i = 0; i < key_size; i++ )
+   if(!(hash->key_flags & HASH_KEY_VARIABLE))
+   {
+      return hash->key_size;
+   }
+
+   if(hash->key_len != NULL)
    {
-      h = ( h << 4 ) + p[i];
-      g = h & 0xf0000000L; 
-      if ( g != 0 )
-         h ^= g >> 24;
-      h &= ~g;
+      return hash->key_len(key);
    }
-   return h;
+   return strlen((char*)key);
+}
+
+static inline unsigned int
+getElementHash(struct list_head* lh)
+{
+   return list_entry(lh, HashElement, lh)->hash_value;
+}
 
-#if 0
-   unsigned int hash = 0;
+static struct list_head*
+allocBuckets(int numBuckets)
+{
+   struct list_head* buckets;
    int i;
 
-   for(i = 0; i < key_size; i++)
+   buckets = (struct list_head*)malloc(sizeof(struct list_head) * numBuckets);
+   if(buckets == NULL)
+   {
+      return NULL;
+   }
+
+   for(i = 0; i < numBuckets; i++)
+   {
+      INIT_LIST_HEAD(&buckets[i]);
+   }
+   return buckets;
+}
+
+static void
+startRehash(HashContext* hash, int numBuckets)
+{
+   hash->newBuckets = allocBuckets(numBuckets);
+   if(hash->newBuckets == NULL)
+   {
+      // keep going with current buckets. we will try again later
+      return;
+   }
+
+   hash->newNumBuckets  = numBuckets;
+   hash->rehashIndex    = 0;
+   hash->stat.resizes++;
+}
+
+static void
+finishRehash(HashContext* hash)
+{
+   free(hash->buckets);
+
+   hash->buckets        = hash->newBuckets;
+   hash->numBuckets     = hash->newNumBuckets;
+   hash->newBuckets     = NULL;
+   hash->newNumBuckets  = 0;
+   hash->rehashIndex    = 0;
+}
+
+static void
+rehashStep(HashContext* hash)
+{
+   int                  moved = 0,
+                        visits = 0;
+   unsigned int         ndx;
+   struct list_head     *pos, *n;
+
+   while(moved < HASH_REHASH_STEP && hash->rehashIndex < hash->numBuckets)
+   {
+      struct list_head* bucket = &hash->buckets[hash->rehashIndex];
+
+      if(list_empty(bucket))
+      {
+         hash->rehashIndex++;
+         if(++visits >= HASH_REHASH_EMPTY_VISITS)
+         {
+            break;
+         }
+         continue;
+      }
+
+      list_for_each_safe(pos, n, bucket)
+      {
+         ndx = getElementHash(pos) % hash->newNumBuckets;
+         list_del(pos);
+         list_add_tail(pos, &hash->newBuckets[ndx]);
+      }
+      hash->rehashIndex++;
+      moved++;
+   }
+
+   if(hash->rehashIndex >= hash->numBuckets)
+   {
+      finishRehash(hash);
+   }
+}
+
+//
+// called once per hash operation.
+// moves a bit of elements if rehashing, or checks load factor
+//
+static void
+checkRehash(HashContext* hash)
+{
+   if(hash->newBuckets != NULL)
+   {
+      rehashStep(hash);
+      return;
+   }
+
+   if(hash->growLoad > 0 &&
+      (long)hash->numElements * 100 > (long)hash->numBuckets * hash->growLoad)
+   {
+      startRehash(hash, hash->numBuckets * 2);
+   }
+   else if(hash->shrinkLoad > 0 && hash->numBuckets / 2 >= hash->minBuckets &&
+      (long)hash->numElements * 100 < (long)hash->numBuckets * hash->shrinkLoad)
+   {
+      startRehash(hash, hash->numBuckets / 2);
+   }
+}
+
+//
+// cached hash value and key length filter out most of the chain before memcmp.
+// stat is NULL for read only lookups, which must not write to hash context
+//
+static inline struct list_head*
+findBucket(HashContext* hash, struct list_head* bucket, void* key, int len,
+      unsigned int hv, HashStat* stat)
+{
+   struct list_head* pos;
+
+   list_for_each(pos, bucket)
+   {
+      if(stat != NULL)
+      {
+         stat->visits++;
+      }
+
+      if(getElementHash(pos) != hv ||
+         list_entry(pos, HashElement, lh)->key_len != len)
+      {
+         continue;
+      }
+
+      if(stat != NULL)
+      {
+         stat->compares++;
+      }
+
+      if(memcmp(key, getElementKey(hash, pos), len) == 0)
+      {
+         return pos;
+      }
+   }
+   return NULL;
+}
+
+static inline struct list_head*
+findHash(HashContext* hash, void* key, int len, unsigned int hv, HashStat* stat)
+{
+   struct list_head* pos;
+
+   // a definite miss never touches the buckets
+   if(hash->bloom != NULL && !checkBloomFilter(hash->bloom, hv))
+   {
+      if(stat != NULL)
+      {
+         stat->finds++;
+         stat->filtered++;
+      }
+      return NULL;
+   }
+
+   pos = findBucket(hash, &hash->buckets[hv % hash->numBuckets], key, len, hv, stat);
+   if(pos == NULL && hash->newBuckets != NULL)
+   {
+      pos = findBucket(hash, &hash->newBuckets[hv % hash->newNumBuckets], key, len, hv, stat);
+   }
+
+   if(stat != NULL)
+   {
+      stat->finds++;
+      if(pos != NULL)
+      {
+         stat->hits++;
+      }
+   }
+   return pos;
+}
+
+static void
+insertHash(HashContext* hash, void* element, int len, unsigned int hv)
+{
+   struct list_head* lh = getElementLH(hash, element);
+
+   list_entry(lh, HashElement, lh)->hash_value  = hv;
+   list_entry(lh, HashElement, lh)->key_len     = len;
+
+   // new elements always go to the new buckets while rehashing
+   if(hash->newBuckets != NULL)
+   {
+      list_add_tail(lh, &hash->newBuckets[hv % hash->newNumBuckets]);
+   }
+   else
+   {
+      list_add_tail(lh, &hash->buckets[hv % hash->numBuckets]);
+   }
+   hash->numElements++;
+   hash->stat.inserts++;
+
+   if(hash->bloom != NULL)
    {
-      hash = key[i] + (hash << 6) + (hash << 16) - hash;
+      addBloomFilter(hash->bloom, hv);
+   }
+}
+
+static inline void
+unlinkHash(HashContext* hash, struct list_head* lh)
+{
+   list_del(lh);
+   hash->numElements--;
+   hash->stat.deletes++;
+
+   if(hash->bloom != NULL)
+   {
+      delBloomFilter(hash->bloom, getElementHash(lh));
    }
-   return hash;
-#endif
 }
-#endif
 
 /**
  * initialize a hash context
@@ -70,13 +311,24 @@ void
 initHash(HashContext* hash, int numBuckets, int hash_offset,
       int key_offset, int key_size, hash_func func)
 {
-   int i ;
+   hash->numBuckets     = numBuckets;
+   hash->offset         = hash_offset;
+   hash->key_offset     = key_offset;
+   hash->key_size       = key_size;
+   hash->key_flags      = 0;
+   hash->key_len        = NULL;
+   hash->buckets        = allocBuckets(numBuckets);
+   hash->numElements    = 0;
+   hash->minBuckets     = numBuckets;
+   hash->growLoad       = HASH_DEFAULT_GROW_LOAD;
+   hash->shrinkLoad     = HASH_DEFAULT_SHRINK_LOAD;
+   hash->newNumBuckets  = 0;
+   hash->newBuckets     = NULL;
+   hash->rehashIndex    = 0;
+   hash->bloom          = NULL;
+
+   memset(&hash->stat, 0, sizeof(hash->stat));
 
-   hash->numBuckets  = numBuckets;
-   hash->offset      = hash_offset;
-   hash->key_offset  = key_offset;
-   hash->key_size    = key_size;
-   hash->buckets     = (struct list_head*)malloc(sizeof(struct list_head) * numBuckets);
    if(func != NULL)
    {
       hash->calc_hash = func;
@@ -85,11 +337,29 @@ initHash(HashContext* hash, int numBuckets, int hash_offset,
    {
       hash->calc_hash   = djb_hash;
    }
+}
 
-   for(i = 0; i < numBuckets; i++)
-   {
-      INIT_LIST_HEAD(&hash->buckets[i]);
-   }
+/**
+ * initialize a hash context with variable length keys
+ * keys are compared by length first and then by contents,
+ * so string keys don't have to be padded to a fixed size
+ *
+ * @param hash hash context block
+ * @param numBuckets number of buckets to use for this hash context
+ * @param hash_offset offset of hash element
+ * @param key_offset offset of hash key, or of a pointer to key with HASH_KEY_INDIRECT
+ * @param key_flags HASH_KEY_INDIRECT or 0
+ * @param key_len returns key length, NUL terminated string key if NULL
+ * @param func hash function to use, use default if NULL
+ */
+void
+initHashVarKey(HashContext* hash, int numBuckets, int hash_offset,
+      int key_offset, int key_flags, hash_key_len_func key_len, hash_func func)
+{
+   initHash(hash, numBuckets, hash_offset, key_offset, 0, func);
+
+   hash->key_flags   = key_flags | HASH_KEY_VARIABLE;
+   hash->key_len     = key_len;
 }
 
 /**
@@ -99,6 +369,25 @@ void
 deinitHash(HashContext* hash)
 {
    free(hash->buckets);
+   free(hash->newBuckets);
+   hash->newBuckets = NULL;
+}
+
+/**
+ * set load factor thresholds for automatic resize
+ * hash grows to double the buckets when elements per bucket exceeds growLoad percent
+ * and shrinks to half when it falls below shrinkLoad percent.
+ * it never shrinks below the number of buckets given to initHash()
+ *
+ * @param hash hash context block
+ * @param growLoad grow threshold in percent, 0 to disable
+ * @param shrinkLoad shrink threshold in percent, 0 to disable
+ */
+void
+setHashLoadFactor(HashContext* hash, int growLoad, int shrinkLoad)
+{
+   hash->growLoad    = growLoad;
+   hash->shrinkLoad  = shrinkLoad;
 }
 
 /**
@@ -111,23 +400,184 @@ deinitHash(HashContext* hash)
 void*
 lookupHash(HashContext* hash, void* key)
 {
-   unsigned int ndx;
    struct list_head* pos;
+   int               len = getKeyLen(hash, key);
 
-   ndx = hash->calc_hash(key, hash->key_size) % hash->numBuckets % hash->numBuckets;
+   checkRehash(hash);
 
-   list_for_each(pos, &hash->buckets[ndx])
+   pos = findHash(hash, key, len, hash->calc_hash(key, len), &hash->stat);
+   if(pos == NULL)
    {
-      char* key2;
+      return NULL;
+   }
+   return getElement(hash, pos);
+}
 
-      key2 = (char*)pos - hash->offset + hash->key_offset;
+//
+// prefetches the first element of a bucket whose head is in cache by now.
+// a key in the element is prefetched along with it, but an indirect key
+// pointer is only known once the element arrives. prefetchElementKey()
+// does that in a later pass, not to stall on the element here
+//
+static inline void
+prefetchElement(HashContext* hash, struct list_head* bucket)
+{
+   struct list_head* pos = bucket->next;
 
-      if(memcmp(key, key2, hash->key_size) == 0)
+   if(pos != bucket)
+   {
+      __builtin_prefetch(pos);
+      if(!(hash->key_flags & HASH_KEY_INDIRECT))
       {
-         return (char*)pos - hash->offset;
+         __builtin_prefetch(getElementKey(hash, pos));
       }
    }
-   return NULL;
+}
+
+static inline void
+prefetchElementKey(HashContext* hash, struct list_head* bucket)
+{
+   struct list_head* pos = bucket->next;
+
+   if(pos != bucket)
+   {
+      __builtin_prefetch(getElementKey(hash, pos));
+   }
+}
+
+/**
+ * lookup hash for a batch of keys
+ * each lookup misses cache on a bucket head and then on an element.
+ * hash values are computed for all keys first and bucket heads,
+ * first elements and indirect keys are prefetched in separate passes,
+ * so the misses of different keys overlap instead of stalling one after
+ * another. while rehashing, buckets of both arrays are prefetched
+ *
+ * @param hash hash context block
+ * @param keys keys to search with
+ * @param n number of keys
+ * @param out out[i] is set to the element found with keys[i] or NULL
+ * @return number of keys found
+ */
+int
+lookupHashBatch(HashContext* hash, void** keys, int n, void** out)
+{
+   unsigned int      hv[HASH_BATCH_SIZE];
+   int               len[HASH_BATCH_SIZE];
+   struct list_head* bucket[HASH_BATCH_SIZE];
+   struct list_head* newBucket[HASH_BATCH_SIZE];
+   struct list_head* pos;
+   int               base,
+                     cnt,
+                     i,
+                     found = 0;
+
+   checkRehash(hash);
+
+   for(base = 0; base < n; base += HASH_BATCH_SIZE)
+   {
+      cnt = n - base < HASH_BATCH_SIZE ? n - base : HASH_BATCH_SIZE;
+
+      for(i = 0; i < cnt; i++)
+      {
+         len[i]      = getKeyLen(hash, keys[base + i]);
+         hv[i]       = hash->calc_hash(keys[base + i], len[i]);
+         newBucket[i] = NULL;
+         if(hash->bloom != NULL && !checkBloomFilter(hash->bloom, hv[i]))
+         {
+            bucket[i] = NULL;
+            continue;
+         }
+         bucket[i]   = &hash->buckets[hv[i] % hash->numBuckets];
+         __builtin_prefetch(bucket[i]);
+
+         if(hash->newBuckets != NULL)
+         {
+            newBucket[i] = &hash->newBuckets[hv[i] % hash->newNumBuckets];
+            __builtin_prefetch(newBucket[i]);
+         }
+      }
+
+      for(i = 0; i < cnt; i++)
+      {
+         if(bucket[i] == NULL)
+         {
+            continue;
+         }
+         prefetchElement(hash, bucket[i]);
+         if(newBucket[i] != NULL)
+         {
+            prefetchElement(hash, newBucket[i]);
+         }
+      }
+
+      for(i = 0; i < cnt && (hash->key_flags & HASH_KEY_INDIRECT); i++)
+      {
+         if(bucket[i] == NULL)
+         {
+            continue;
+         }
+         prefetchElementKey(hash, bucket[i]);
+         if(newBucket[i] != NULL)
+         {
+            prefetchElementKey(hash, newBucket[i]);
+         }
+      }
+
+      for(i = 0; i < cnt; i++)
+      {
+         pos = findHash(hash, keys[base + i], len[i], hv[i], &hash->stat);
+         if(pos != NULL)
+         {
+            out[base + i] = getElement(hash, pos);
+            found++;
+         }
+         else
+         {
+            out[base + i] = NULL;
+         }
+      }
+   }
+   return found;
+}
+
+/**
+ * lookup hash for a given key without moving elements for incremental rehash
+ * hash context is not modified at all, so concurrent callers can share
+ * a read lock as long as nobody adds or deletes at the same time
+ *
+ * @param hash hash context block
+ * @param key key to search with
+ * @return NULL when key is not found, pointer to client structure when found
+ */
+void*
+peekHash(HashContext* hash, void* key)
+{
+   int len = getKeyLen(hash, key);
+
+   return peekHashWithValue(hash, key, hash->calc_hash(key, len));
+}
+
+/**
+ * peekHash() with the hash value of key already calculated
+ * for callers that hash the key anyway, e.g. to pick a shard
+ *
+ * @param hash hash context block
+ * @param key key to search with
+ * @param hv hash value of key by hash->calc_hash
+ * @return NULL when key is not found, pointer to client structure when found
+ */
+void*
+peekHashWithValue(HashContext* hash, void* key, unsigned int hv)
+{
+   struct list_head* pos;
+
+   pos = findHash(hash, key, getKeyLen(hash, key), hv, NULL);
+   if(pos == NULL)
+   {
+      return NULL;
+   }
+   return getElement(hash, pos);
 }
 
 /**
@@ -140,24 +590,72 @@ lookupHash(HashContext* hash, void* key)
 int
 addHash(HashContext* hash, void* element)
 {
-   unsigned int ndx;
+   char* key = getKeyFromElement(hash, element);
+
+   return addHashWithValue(hash, element,
+         hash->calc_hash((unsigned char*)key, getKeyLen(hash, key)));
+}
+
+/**
+ * addHash() with the hash value of element key already calculated
+ *
+ * @param hash hash context block
+ * @param element hash client element
+ * @param hv hash value of element key by hash->calc_hash
+ * @return 0 on failure, 1 on success
+ */
+int
+addHashWithValue(HashContext* hash, void* element, unsigned int hv)
+{
    char* key;
-   struct list_head* lh;
+   int len;
+
+   checkRehash(hash);
 
-   key = (char*)element + hash->key_offset;
-   lh = (struct list_head*)((char*)element + hash->offset);
+   key = getKeyFromElement(hash, element);
+   len = getKeyLen(hash, key);
 
-   if(lookupHash(hash, key) != NULL)
+   if(findHash(hash, key, len, hv, &hash->stat) != NULL)
    {
       return 0;
    }
 
-   ndx = hash->calc_hash((unsigned char*)key, hash->key_size) % hash->numBuckets;
-
-   list_add_tail(lh, &hash->buckets[ndx]);
+   insertHash(hash, element, len, hv);
    return 1;
 }
 
+/**
+ * lookup hash with the key of a given element and add the element if not found
+ * the chain is walked only once for lookup and insertion
+ *
+ * @param hash hash context block
+ * @param element hash client element to add
+ * @return element already in hash with the same key, or element itself if added
+ */
+void*
+lookupOrAddHash(HashContext* hash, void* element)
+{
+   unsigned int hv;
+   char* key;
+   int len;
+   struct list_head* pos;
+
+   checkRehash(hash);
+
+   key = getKeyFromElement(hash, element);
+   len = getKeyLen(hash, key);
+   hv = hash->calc_hash((unsigned char*)key, len);
+
+   pos = findHash(hash, key, len, hv, &hash->stat);
+   if(pos != NULL)
+   {
+      return getElement(hash, pos);
+   }
+
+   insertHash(hash, element, len, hv);
+   return element;
+}
+
 /**
  * delete a hash client element with given key from hash context
  *
@@ -168,27 +666,219 @@ addHash(HashContext* hash, void* element)
 int
 delHash(HashContext* hash, void* key)
 {
-   if(lookupHash(hash, key) == NULL)
+   return removeHash(hash, key) != NULL;
+}
+
+/**
+ * delete a hash client element with given key from hash context
+ * and return the element deleted
+ *
+ * @param hash hash context block
+ * @param key hash key to search with
+ * @return element deleted, or NULL if not found
+ */
+void*
+removeHash(HashContext* hash, void* key)
+{
+   int len = getKeyLen(hash, key);
+
+   return removeHashWithValue(hash, key, hash->calc_hash(key, len));
+}
+
+/**
+ * removeHash() with the hash value of key already calculated
+ *
+ * @param hash hash context block
+ * @param key hash key to search with
+ * @param hv hash value of key by hash->calc_hash
+ * @return element deleted, or NULL if not found
+ */
+void*
+removeHashWithValue(HashContext* hash, void* key, unsigned int hv)
+{
+   struct list_head* pos;
+
+   checkRehash(hash);
+
+   pos = findHash(hash, key, getKeyLen(hash, key), hv, &hash->stat);
+   if(pos == NULL)
    {
-      return 0;
+      return NULL;
    }
 
-   unsigned int ndx;
-   struct list_head* pos;
+   unlinkHash(hash, pos);
+   return getElement(hash, pos);
+}
+
+/**
+ * delete a hash client element already known to be in hash context
+ * no hash calculation or chain walk is needed
+ *
+ * @param hash hash context block
+ * @param element hash client element in the hash
+ */
+void
+delHashElement(HashContext* hash, void* element)
+{
+   checkRehash(hash);
 
-   ndx = hash->calc_hash((unsigned char*)key, hash->key_size) % hash->numBuckets;
+   unlinkHash(hash, getElementLH(hash, element));
+}
 
-   list_for_each(pos, &hash->buckets[ndx])
+/**
+ * iterate over all the elements in hash
+ * the iterator must not add or delete elements.
+ * it may free the element given, in which case the hash
+ * must be deinitialized right after iteration
+ *
+ * @param hash hash context block
+ * @param it iteration callback
+ * @param priv private argument for iteration callback
+ */
+void
+iterateHash(HashContext* hash, hash_iterator it, void* priv)
+{
+   struct list_head *pos, *n;
+   int i;
+
+   for(i = 0; i < hash->numBuckets; i++)
    {
-      char* key2;
+      list_for_each_safe(pos, n, &hash->buckets[i])
+      {
+         it(hash, getElement(hash, pos), priv);
+      }
+   }
 
-      key2 = (char*)pos - hash->offset + hash->key_offset;
+   if(hash->newBuckets == NULL)
+   {
+      return;
+   }
 
-      if(memcmp(key, key2, hash->key_size) == 0)
+   for(i = 0; i < hash->newNumBuckets; i++)
+   {
+      list_for_each_safe(pos, n, &hash->newBuckets[i])
       {
-         list_del(pos);
-         return 1;
+         it(hash, getElement(hash, pos), priv);
+      }
+   }
+}
+
+static void
+countChains(struct list_head* buckets, int numBuckets, int* hist, int* maxChain)
+{
+   struct list_head* pos;
+   int i, len;
+
+   for(i = 0; i < numBuckets; i++)
+   {
+      len = 0;
+      list_for_each(pos, &buckets[i])
+      {
+         len++;
+      }
+
+      hist[len < HASH_STAT_MAX_CHAIN ? len : HASH_STAT_MAX_CHAIN]++;
+      if(len > *maxChain)
+      {
+         *maxChain = len;
       }
    }
-   return 0;
+}
+
+/**
+ * print hash statistics to fp
+ * operation counters are always kept. chain lengths are counted
+ * by walking all the buckets, so don't call it on a hot path
+ *
+ * @param hash hash context block
+ * @param fp file pointer to write statistics to
+ */
+void
+printHashStat(HashContext* hash, FILE* fp)
+{
+   HashStat*   stat = &hash->stat;
+   int         hist[HASH_STAT_MAX_CHAIN + 1],
+               maxChain = 0,
+               nonEmpty,
+               i;
+
+   memset(hist, 0, sizeof(hist));
+
+   countChains(hash->buckets, hash->numBuckets, hist, &maxChain);
+   if(hash->newBuckets != NULL)
+   {
+      countChains(hash->newBuckets, hash->newNumBuckets, hist, &maxChain);
+   }
+   nonEmpty = hash->numBuckets + hash->newNumBuckets - hist[0];
+
+   fprintf(fp, "=============== HASH STATISTICS ==============\n");
+   fprintf(fp, "ELEMENTS %d, BUCKETS %d, LOAD FACTOR %.2f%s\n",
+         hash->numElements, hash->numBuckets,
+         (double)hash->numElements / hash->numBuckets,
+         hash->newBuckets != NULL ? ", REHASHING" : "");
+   fprintf(fp, "CHAIN MAX %d, AVG %.2f (non empty buckets)\n",
+         maxChain, nonEmpty > 0 ? (double)hash->numElements / nonEmpty : 0.0);
+
+   fprintf(fp, "CHAIN HISTOGRAM");
+   for(i = 0; i <= HASH_STAT_MAX_CHAIN; i++)
+   {
+      fprintf(fp, " %d%s:%d", i, i == HASH_STAT_MAX_CHAIN ? "+" : "", hist[i]);
+   }
+   fprintf(fp, "\n");
+
+   fprintf(fp, "FINDS %lu, HITS %lu, INSERTS %lu, DELETES %lu, RESIZES %lu\n",
+         stat->finds, stat->hits, stat->inserts, stat->deletes, stat->resizes);
+   fprintf(fp, "VISITS/FIND %.2f, COMPARES/FIND %.2f\n",
+         stat->finds > 0 ? (double)stat->visits / stat->finds : 0.0,
+         stat->finds > 0 ? (double)stat->compares / stat->finds : 0.0);
+   if(hash->bloom != NULL)
+   {
+      fprintf(fp, "BLOOM FILTERED %lu (%.2f%% of misses)\n", stat->filtered,
+            stat->finds > stat->hits ?
+            (double)stat->filtered * 100 / (stat->finds - stat->hits) : 0.0);
+   }
+   fflush(fp);
+}
+
+/**
+ * reset hash operation counters
+ *
+ * @param hash hash context block
+ */
+void
+resetHashStat(HashContext* hash)
+{
+   memset(&hash->stat, 0, sizeof(hash->stat));
+}
+
+static void
+addBloomElement(HashContext* hash, void* element, void* priv)
+{
+   addBloomFilter((BloomFilter*)priv, getElementHash(getElementLH(hash, element)));
+}
+
+/**
+ * attach a bloom filter to hash
+ * lookups of keys not in hash are mostly rejected by the filter
+ * with a single cache line access instead of a chain walk.
+ * elements already in hash are added to the filter. after that
+ * the filter is kept up to date by hash operations. with a non counting
+ * filter, deleted keys stay in the filter and only cost false positives,
+ * so clear and attach again after lots of deletes
+ *
+ * @param hash hash context block
+ * @param bf bloom filter to attach, NULL to detach
+ */
+void
+attachHashBloomFilter(HashContext* hash, BloomFilter* bf)
+{
+   hash->bloom = NULL;
+   if(bf == NULL)
+   {
+      return;
+   }
+
+   clearBloomFilter(bf);
+   iterateHash(hash, addBloomElement, bf);
+   hash->bloom = bf;
 }
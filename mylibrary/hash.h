@@ -12,6 +12,7 @@
 
 #include <stdio.h>
 #include "list.h"
+#include "bloom_filter.h"
 
 /**
  * a structure for hash element
@@ -19,6 +20,8 @@
 typedef struct hash_element
 {
    struct list_head  lh;         /** a list for buck hash list management */
+   unsigned int      hash_value; /** hash value of the key cached at insertion */
+   int               key_len;    /** key length cached at insertion */
 } HashElement;
 
 /**
@@ -26,24 +29,87 @@ typedef struct hash_element
  */
 typedef unsigned int (*hash_func)(unsigned char* key, int key_size);
 
+/**
+ * returns length of a variable length key
+ */
+typedef int (*hash_key_len_func)(void* key);
+
+#define HASH_KEY_VARIABLE     (1 << 0)    /** key length varies per element        */
+#define HASH_KEY_INDIRECT     (1 << 1)    /** element holds a pointer to key       */
+
+/**
+ * hash operation counters
+ * cheap enough to be always on. peekHash() doesn't count
+ * so that concurrent readers never write to hash context
+ */
+typedef struct hash_stat
+{
+   unsigned long     finds;            /** number of key searches             */
+   unsigned long     hits;             /** number of searches found           */
+   unsigned long     visits;           /** chain elements visited             */
+   unsigned long     compares;         /** key compares after hash value matched */
+   unsigned long     inserts;          /** number of elements added           */
+   unsigned long     deletes;          /** number of elements deleted         */
+   unsigned long     resizes;          /** number of rehashes started         */
+   unsigned long     filtered;         /** misses rejected by bloom filter    */
+} HashStat;
+
 /**
  * a hash context
+ *
+ * bucket array grows or shrinks when load factor crosses the thresholds.
+ * elements are moved to the new bucket array a few buckets at a time
+ * by subsequent hash operations, so no single operation rehashes the whole table
  */
 typedef struct hash_context
 {
    int               numBuckets;       /** number of buckets                  */
    int               offset;           /** offset of hash element             */
    int               key_offset;       /** hash key offset                    */
-   int               key_size;         /** hash key size                      */
+   int               key_size;         /** hash key size, unused for variable keys */
+   int               key_flags;        /** HASH_KEY_VARIABLE, HASH_KEY_INDIRECT    */
+   hash_key_len_func key_len;          /** variable key length, strlen if NULL     */
    hash_func         calc_hash;        /** hash function to use               */
    struct list_head* buckets;          /** bucket list                        */
+   int               numElements;      /** number of elements in hash         */
+   int               minBuckets;       /** never shrink below this            */
+   int               growLoad;         /** grow load factor in percent, 0 to disable    */
+   int               shrinkLoad;       /** shrink load factor in percent, 0 to disable  */
+   int               newNumBuckets;    /** number of buckets being rehashed into        */
+   struct list_head* newBuckets;       /** bucket list being rehashed into, or NULL     */
+   int               rehashIndex;      /** next bucket to move to newBuckets            */
+   HashStat          stat;             /** operation counters                           */
+   BloomFilter*      bloom;            /** filter for definite misses, or NULL          */
 } HashContext;
 
+/**
+ * hash iteration callback
+ */
+typedef void (*hash_iterator)(HashContext* hash, void* element, void* priv);
+
+#define HASH_DEFAULT_GROW_LOAD      200   /** grow when there are 2 elements per bucket */
+#define HASH_DEFAULT_SHRINK_LOAD    0     /** no shrink by default                      */
+
 extern void initHash(HashContext* hash, int numBuckets, int hash_offset,
       int key_offset, int key_size, hash_func func);
+extern void initHashVarKey(HashContext* hash, int numBuckets, int hash_offset,
+      int key_offset, int key_flags, hash_key_len_func key_len, hash_func func);
 extern void deinitHash(HashContext* hash);
 extern int addHash(HashContext* hash, void* element);
+extern int addHashWithValue(HashContext* hash, void* element, unsigned int hv);
 extern void* lookupHash(HashContext* hash, void* key);
+extern void* peekHash(HashContext* hash, void* key);
+extern void* peekHashWithValue(HashContext* hash, void* key, unsigned int hv);
+extern int lookupHashBatch(HashContext* hash, void** keys, int n, void** out);
 extern int delHash(HashContext* hash, void* key);
+extern void* lookupOrAddHash(HashContext* hash, void* element);
+extern void* removeHash(HashContext* hash, void* key);
+extern void* removeHashWithValue(HashContext* hash, void* key, unsigned int hv);
+extern void delHashElement(HashContext* hash, void* element);
+extern void setHashLoadFactor(HashContext* hash, int growLoad, int shrinkLoad);
+extern void iterateHash(HashContext* hash, hash_iterator it, void* priv);
+extern void printHashStat(HashContext* hash, FILE* fp);
+extern void resetHashStat(HashContext* hash);
+extern void attachHashBloomFilter(HashContext* hash, BloomFilter* bf);
 
 #endif //!__HASH_DEF_H__
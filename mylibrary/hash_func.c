@@ -0,0 +1,289 @@
+//
+// hash functions for hash contexts
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent, djb_hash moved from hash.c
+//
+//
+#include <stdint.h>
+#include <string.h>
+#include "hash_func.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#define CRC32C_POLY        0x82f63b78
+
+//
+// wyhash constants
+//
+#define WY_P0              0xa0761d6478bd642full
+#define WY_P1              0xe7037ed1a0b428dbull
+#define WY_P2              0x8ebc6af09c88c6e3ull
+#define WY_P3              0x589965cc75374cc3ull
+
+/**
+ * hash function table for lookupHashFunc()
+ */
+static struct
+{
+   const char*    name;
+   hash_func      func;
+} hashFuncs[] =
+{
+   { "djb",       djb_hash    },
+   { "fnv1a",     fnv1a_hash  },
+   { "wyhash",    wy_hash     },
+   { "crc32c",    crc32c_hash },
+};
+
+static unsigned int  crc32cTable[256];
+static int           crc32cHw;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+static void __attribute__((constructor))
+initHashFunc(void)
+{
+   unsigned int   c;
+   int            i, j;
+
+   for(i = 0; i < 256; i++)
+   {
+      c = i;
+      for(j = 0; j < 8; j++)
+      {
+         c = (c >> 1) ^ (CRC32C_POLY & -(c & 1));
+      }
+      crc32cTable[i] = c;
+   }
+
+#if defined(__x86_64__)
+   __builtin_cpu_init();
+   crc32cHw = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+static inline uint64_t
+read64(unsigned char* p)
+{
+   uint64_t v;
+
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline uint64_t
+read32(unsigned char* p)
+{
+   uint32_t v;
+
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline uint64_t
+wy_mum(uint64_t a, uint64_t b)
+{
+   __uint128_t r = (__uint128_t)a * b;
+
+   return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static unsigned int
+crc32c_sw(unsigned char* key, int key_size)
+{
+   unsigned int   crc = ~0u;
+   int            i;
+
+   for(i = 0; i < key_size; i++)
+   {
+      crc = crc32cTable[(crc ^ key[i]) & 0xff] ^ (crc >> 8);
+   }
+   return ~crc;
+}
+
+#if defined(__x86_64__)
+static unsigned int __attribute__((target("sse4.2")))
+crc32c_hw(unsigned char* key, int key_size)
+{
+   uint64_t    crc = ~0u;
+
+   while(key_size >= 8)
+   {
+      crc = _mm_crc32_u64(crc, read64(key));
+      key      += 8;
+      key_size -= 8;
+   }
+
+   if(key_size >= 4)
+   {
+      crc = _mm_crc32_u32((unsigned int)crc, (unsigned int)read32(key));
+      key      += 4;
+      key_size -= 4;
+   }
+
+   while(key_size > 0)
+   {
+      crc = _mm_crc32_u8((unsigned int)crc, *key++);
+      key_size--;
+   }
+   return ~(unsigned int)crc;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * the classic byte at a time hash, 33 * h ^ c.
+ * default for hash contexts
+ */
+unsigned int
+djb_hash(unsigned char* key, int key_size)
+{
+   unsigned int h = 0;
+   int i;
+
+   for(i = 0; i < key_size; i++)
+   {
+      h = 33 * h ^ key[i];
+   }
+   return h;
+}
+
+/**
+ * 32 bit FNV-1a. byte at a time, but mixes better than djb
+ */
+unsigned int
+fnv1a_hash(unsigned char* key, int key_size)
+{
+   unsigned int h = 2166136261u;
+   int i;
+
+   for(i = 0; i < key_size; i++)
+   {
+      h = (h ^ key[i]) * 16777619u;
+   }
+   return h;
+}
+
+/**
+ * wyhash. consumes 8 bytes at a time with 64x64->128 multiplication.
+ * 64 bit result is folded to 32 bits
+ */
+unsigned int
+wy_hash(unsigned char* key, int key_size)
+{
+   unsigned char* p = key;
+   uint64_t       len = (uint64_t)key_size,
+                  seed = WY_P0,
+                  a, b, h;
+   int            i = key_size;
+
+   if(len <= 16)
+   {
+      if(len >= 4)
+      {
+         a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+         b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+      }
+      else if(len > 0)
+      {
+         a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+         b = 0;
+      }
+      else
+      {
+         a = b = 0;
+      }
+   }
+   else
+   {
+      if(i > 48)
+      {
+         uint64_t s1 = seed, s2 = seed;
+
+         do
+         {
+            seed  = wy_mum(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+            s1    = wy_mum(read64(p + 16) ^ WY_P2, read64(p + 24) ^ s1);
+            s2    = wy_mum(read64(p + 32) ^ WY_P3, read64(p + 40) ^ s2);
+            p    += 48;
+            i    -= 48;
+         } while(i > 48);
+
+         seed ^= s1 ^ s2;
+      }
+
+      while(i > 16)
+      {
+         seed  = wy_mum(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+         p    += 16;
+         i    -= 16;
+      }
+
+      a = read64(p + i - 16);
+      b = read64(p + i - 8);
+   }
+
+   h = wy_mum(WY_P1 ^ len, wy_mum(a ^ WY_P1, b ^ seed));
+   return (unsigned int)(h ^ (h >> 32));
+}
+
+/**
+ * CRC32C. uses SSE4.2 crc32 instruction when CPU supports it,
+ * table driven otherwise. both produce the same value
+ */
+unsigned int
+crc32c_hash(unsigned char* key, int key_size)
+{
+#if defined(__x86_64__)
+   if(crc32cHw)
+   {
+      return crc32c_hw(key, key_size);
+   }
+#endif
+   return crc32c_sw(key, key_size);
+}
+
+/**
+ * check if crc32c_hash() runs on hardware instruction
+ *
+ * @return 1 if hardware crc32c is used, 0 otherwise
+ */
+int
+hasHardwareCrc32c(void)
+{
+   return crc32cHw;
+}
+
+/**
+ * find a hash function by name
+ * so that hash function can be chosen by configuration
+ *
+ * @param name one of "djb", "fnv1a", "wyhash", "crc32c"
+ * @return hash function or NULL if not found
+ */
+hash_func
+lookupHashFunc(const char* name)
+{
+   int i;
+
+   for(i = 0; i < sizeof(hashFuncs) / sizeof(hashFuncs[0]); i++)
+   {
+      if(strcmp(hashFuncs[i].name, name) == 0)
+      {
+         return hashFuncs[i].func;
+      }
+   }
+   return NULL;
+}
@@ -0,0 +1,23 @@
+//
+// hash functions for hash contexts
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent, djb_hash moved from hash.c
+//
+//
+#ifndef __HASH_FUNC_DEF_H__
+#define __HASH_FUNC_DEF_H__
+
+#include "hash.h"
+
+extern unsigned int djb_hash(unsigned char* key, int key_size);
+extern unsigned int fnv1a_hash(unsigned char* key, int key_size);
+extern unsigned int wy_hash(unsigned char* key, int key_size);
+extern unsigned int crc32c_hash(unsigned char* key, int key_size);
+
+extern hash_func lookupHashFunc(const char* name);
+extern int hasHardwareCrc32c(void);
+
+#endif //!__HASH_FUNC_DEF_H__
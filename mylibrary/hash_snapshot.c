@@ -0,0 +1,492 @@
+//
+// a read only memory mapped image of hash
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hash_snapshot.h"
+#include "hash_func.h"
+
+//
+// image layout
+//
+// header | bucket index | entries | keys | element data
+//
+// bucket index is a prefix sum of entries per bucket, so a lookup reads
+// one bucket index slot and scans a contiguous run of entries.
+// element data is 64 byte aligned and each element 8 byte aligned
+// so that it can be used in place
+//
+#define SNAPSHOT_ALIGN(x, a)     (((x) + (a) - 1) & ~((uint64_t)(a) - 1))
+
+static const char snapshotCheckKey[] = "hash snapshot check";
+
+//
+// the image might be truncated or corrupted. every offset read from it is
+// checked to be in [lo, hi) with overflow safe arithmetic before use
+//
+static inline int
+inSnapshotRange(uint64_t off, uint64_t len, uint64_t lo, uint64_t hi)
+{
+   return off >= lo && off <= hi && len <= hi - off;
+}
+
+typedef struct
+{
+   void**   elems;
+   int      n;
+} SnapshotCollector;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+static inline HashElement*
+getSnapshotElement(HashContext* hash, void* element)
+{
+   return (HashElement*)((char*)element + hash->offset);
+}
+
+static inline void*
+getSnapshotKey(HashContext* hash, void* element)
+{
+   char* key = (char*)element + hash->key_offset;
+
+   if(hash->key_flags & HASH_KEY_INDIRECT)
+   {
+      return *(char**)key;
+   }
+   return key;
+}
+
+static void
+collectElement(HashContext* hash, void* element, void* priv)
+{
+   SnapshotCollector* c = (SnapshotCollector*)priv;
+
+   c->elems[c->n++] = element;
+}
+
+static int
+writePad(FILE* fp, uint64_t from, uint64_t to)
+{
+   static const char zero[64];
+
+   while(from < to)
+   {
+      size_t n = to - from < sizeof(zero) ? to - from : sizeof(zero);
+
+      if(fwrite(zero, 1, n, fp) != n)
+      {
+         return -1;
+      }
+      from += n;
+   }
+   return 0;
+}
+
+static int
+writeSnapshot(FILE* fp, HashContext* hash, void** sorted, uint32_t* buckets,
+      HashSnapshotHeader* h)
+{
+   HashSnapshotEntry    entry;
+   HashElement*         he;
+   uint64_t             key_offset,
+                        data_offset,
+                        data_start,
+                        pos;
+   uint32_t             stride = SNAPSHOT_ALIGN(h->elem_size, 8),
+                        i;
+
+   if(fwrite(h, sizeof(*h), 1, fp) != 1 ||
+      writePad(fp, sizeof(*h), h->bucket_offset) != 0 ||
+      fwrite(buckets, sizeof(uint32_t), h->numBuckets + 1, fp) != h->numBuckets + 1 ||
+      writePad(fp, h->bucket_offset + sizeof(uint32_t) * (h->numBuckets + 1),
+         h->entry_offset) != 0)
+   {
+      return -1;
+   }
+
+   key_offset = h->entry_offset + sizeof(HashSnapshotEntry) * (uint64_t)h->numElements;
+   pos = key_offset;
+   for(i = 0; i < h->numElements; i++)
+   {
+      pos += getSnapshotElement(hash, sorted[i])->key_len;
+   }
+   data_start = SNAPSHOT_ALIGN(pos, 64);
+
+   h->key_region  = key_offset;
+   h->data_region = data_start;
+
+   data_offset = data_start;
+   for(i = 0; i < h->numElements; i++)
+   {
+      he = getSnapshotElement(hash, sorted[i]);
+
+      entry.hash_value  = he->hash_value;
+      entry.key_len     = he->key_len;
+      entry.key_offset  = key_offset;
+      entry.data_offset = data_offset;
+      if(fwrite(&entry, sizeof(entry), 1, fp) != 1)
+      {
+         return -1;
+      }
+      key_offset  += he->key_len;
+      data_offset += stride;
+   }
+
+   for(i = 0; i < h->numElements; i++)
+   {
+      he = getSnapshotElement(hash, sorted[i]);
+      if(fwrite(getSnapshotKey(hash, sorted[i]), 1, he->key_len, fp) != (size_t)he->key_len)
+      {
+         return -1;
+      }
+   }
+
+   if(writePad(fp, pos, data_start) != 0)
+   {
+      return -1;
+   }
+
+   for(i = 0; i < h->numElements; i++)
+   {
+      if(fwrite(sorted[i], 1, h->elem_size, fp) != h->elem_size ||
+         writePad(fp, h->elem_size, stride) != 0)
+      {
+         return -1;
+      }
+   }
+
+   h->file_size = data_offset;
+   return 0;
+}
+
+//
+// a bucket covers entries [buckets[i], buckets[i + 1]),
+// so the index has to be non decreasing and end at numElements
+//
+static int
+checkSnapshotBuckets(HashSnapshot* snap)
+{
+   uint32_t i;
+
+   if(snap->buckets[0] != 0 ||
+      snap->buckets[snap->header->numBuckets] != snap->header->numElements)
+   {
+      return -1;
+   }
+
+   for(i = 0; i < snap->header->numBuckets; i++)
+   {
+      if(snap->buckets[i] > snap->buckets[i + 1])
+      {
+         return -1;
+      }
+   }
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * save a snapshot image of hash to a file
+ * element bytes are copied as they are, so pointers in elements,
+ * including HashElement and indirect key pointers, are meaningless
+ * in the image. keys are copied separately and are always usable.
+ * the image is written to a temporary file, synced to disk and renamed
+ * to path, so readers never see a partial image even after a crash
+ *
+ * @param hash hash context block
+ * @param elem_size size of client element
+ * @param path file to save to
+ * @return 0 on success, -1 on failure
+ */
+int
+saveHashSnapshot(HashContext* hash, int elem_size, const char* path)
+{
+   HashSnapshotHeader   h;
+   SnapshotCollector    c;
+   void**               sorted = NULL;
+   uint32_t*            buckets = NULL;
+   uint32_t*            cursor = NULL;
+   uint32_t             numBuckets = 1,
+                        b;
+   char*                tmp = NULL;
+   FILE*                fp = NULL;
+   int                  i,
+                        ret = -1;
+
+   while(numBuckets < (uint32_t)hash->numElements)
+   {
+      numBuckets *= 2;
+   }
+
+   c.n      = 0;
+   c.elems  = (void**)malloc(sizeof(void*) * (hash->numElements + 1));
+   sorted   = (void**)malloc(sizeof(void*) * (hash->numElements + 1));
+   buckets  = (uint32_t*)calloc(numBuckets + 1, sizeof(uint32_t));
+   cursor   = (uint32_t*)malloc(sizeof(uint32_t) * numBuckets);
+   tmp      = (char*)malloc(strlen(path) + 5);
+   if(c.elems == NULL || sorted == NULL || buckets == NULL || cursor == NULL || tmp == NULL)
+   {
+      goto out;
+   }
+
+   iterateHash(hash, collectElement, &c);
+
+   // counting sort by bucket
+   for(i = 0; i < c.n; i++)
+   {
+      buckets[(getSnapshotElement(hash, c.elems[i])->hash_value & (numBuckets - 1)) + 1]++;
+   }
+   for(b = 0; b < numBuckets; b++)
+   {
+      buckets[b + 1] += buckets[b];
+      cursor[b] = buckets[b];
+   }
+   for(i = 0; i < c.n; i++)
+   {
+      b = getSnapshotElement(hash, c.elems[i])->hash_value & (numBuckets - 1);
+      sorted[cursor[b]++] = c.elems[i];
+   }
+
+   memset(&h, 0, sizeof(h));
+   h.magic           = HASH_SNAPSHOT_MAGIC;
+   h.version         = HASH_SNAPSHOT_VERSION;
+   h.key_flags       = hash->key_flags;
+   h.key_size        = hash->key_size;
+   h.elem_size       = elem_size;
+   h.numBuckets      = numBuckets;
+   h.numElements     = c.n;
+   h.hash_check      = hash->calc_hash((unsigned char*)snapshotCheckKey,
+                           sizeof(snapshotCheckKey) - 1);
+   h.bucket_offset   = SNAPSHOT_ALIGN(sizeof(h), 8);
+   h.entry_offset    = SNAPSHOT_ALIGN(h.bucket_offset + sizeof(uint32_t) * (numBuckets + 1), 8);
+
+   sprintf(tmp, "%s.tmp", path);
+   fp = fopen(tmp, "w");
+   if(fp == NULL)
+   {
+      goto out;
+   }
+
+   // header is written again once file size is known
+   if(writeSnapshot(fp, hash, sorted, buckets, &h) != 0 ||
+      fseek(fp, 0, SEEK_SET) != 0 ||
+      fwrite(&h, sizeof(h), 1, fp) != 1)
+   {
+      goto out;
+   }
+
+   //
+   // data must be on disk before rename. otherwise after a crash
+   // the rename might survive while the data doesn't
+   //
+   if(fflush(fp) != 0 || fsync(fileno(fp)) != 0)
+   {
+      goto out;
+   }
+
+   if(fclose(fp) != 0)
+   {
+      fp = NULL;
+      goto out;
+   }
+   fp = NULL;
+
+   if(rename(tmp, path) != 0)
+   {
+      goto out;
+   }
+   ret = 0;
+
+out:
+   if(fp != NULL)
+   {
+      fclose(fp);
+   }
+   if(ret != 0 && tmp != NULL)
+   {
+      unlink(tmp);
+   }
+   free(tmp);
+   free(cursor);
+   free(buckets);
+   free(sorted);
+   free(c.elems);
+   return ret;
+}
+
+/**
+ * map a snapshot image read only
+ * pages are shared with other processes mapping the same file and
+ * loaded on demand. the header and bucket index are validated here,
+ * and offsets of an entry when a lookup matches it, so a truncated or
+ * corrupted image never makes a lookup read outside the mapping
+ *
+ * @param snap snapshot to initialize
+ * @param path snapshot file
+ * @param func hash function the image was saved with, use default if NULL
+ * @return 0 on success, -1 on failure or if the image is not valid
+ */
+int
+openHashSnapshot(HashSnapshot* snap, const char* path, hash_func func)
+{
+   struct stat          st;
+   HashSnapshotHeader*  h;
+   void*                base;
+   int                  fd;
+
+   fd = open(path, O_RDONLY);
+   if(fd < 0)
+   {
+      return -1;
+   }
+
+   if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(HashSnapshotHeader))
+   {
+      close(fd);
+      return -1;
+   }
+
+   base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if(base == MAP_FAILED)
+   {
+      return -1;
+   }
+
+   snap->base        = (char*)base;
+   snap->size        = st.st_size;
+   snap->calc_hash   = func != NULL ? func : djb_hash;
+
+   //
+   // regions must be in order, aligned and inside the file:
+   // header <= bucket index <= entries <= keys <= element data <= file size
+   //
+   h = (HashSnapshotHeader*)base;
+   if(h->magic != HASH_SNAPSHOT_MAGIC ||
+      h->version != HASH_SNAPSHOT_VERSION ||
+      h->file_size != snap->size ||
+      h->numBuckets == 0 || (h->numBuckets & (h->numBuckets - 1)) != 0 ||
+      h->bucket_offset % 8 != 0 || h->entry_offset % 8 != 0 || h->data_region % 8 != 0 ||
+      !inSnapshotRange(h->bucket_offset, sizeof(uint32_t) * ((uint64_t)h->numBuckets + 1),
+         sizeof(*h), h->entry_offset) ||
+      !inSnapshotRange(h->entry_offset, sizeof(HashSnapshotEntry) * (uint64_t)h->numElements,
+         h->entry_offset, h->key_region) ||
+      !inSnapshotRange(h->key_region, 0, h->key_region, h->data_region) ||
+      !inSnapshotRange(h->data_region,
+         SNAPSHOT_ALIGN((uint64_t)h->elem_size, 8) * h->numElements,
+         h->data_region, h->file_size) ||
+      h->hash_check != snap->calc_hash((unsigned char*)snapshotCheckKey,
+                           sizeof(snapshotCheckKey) - 1))
+   {
+      munmap(base, st.st_size);
+      return -1;
+   }
+
+   snap->header   = h;
+   snap->buckets  = (uint32_t*)(snap->base + h->bucket_offset);
+   snap->entries  = (HashSnapshotEntry*)(snap->base + h->entry_offset);
+
+   if(checkSnapshotBuckets(snap) != 0)
+   {
+      munmap(base, st.st_size);
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * unmap a snapshot image
+ * elements returned by lookups are no longer valid after this
+ *
+ * @param snap snapshot
+ */
+void
+closeHashSnapshot(HashSnapshot* snap)
+{
+   munmap(snap->base, snap->size);
+   snap->base = NULL;
+}
+
+/**
+ * lookup snapshot with a key of given length
+ *
+ * @param snap snapshot
+ * @param key key to search with
+ * @param len key length
+ * @return NULL when key is not found, pointer to read only element when found
+ */
+const void*
+lookupHashSnapshotLen(HashSnapshot* snap, const void* key, int len)
+{
+   unsigned int         hv = snap->calc_hash((unsigned char*)key, len);
+   uint32_t             b = hv & (snap->header->numBuckets - 1),
+                        i;
+   HashSnapshotEntry*   e;
+
+   for(i = snap->buckets[b]; i < snap->buckets[b + 1]; i++)
+   {
+      e = &snap->entries[i];
+      if(e->hash_value != hv || e->key_len != (uint32_t)len)
+      {
+         continue;
+      }
+
+      // entry offsets are not checked at open, which would touch the whole image
+      if(!inSnapshotRange(e->key_offset, len, snap->header->key_region,
+            snap->header->data_region) ||
+         !inSnapshotRange(e->data_offset, snap->header->elem_size,
+            snap->header->data_region, snap->header->file_size) ||
+         e->data_offset % 8 != 0)
+      {
+         continue;
+      }
+
+      if(memcmp(key, snap->base + e->key_offset, len) == 0)
+      {
+         return snap->base + e->data_offset;
+      }
+   }
+   return NULL;
+}
+
+/**
+ * lookup snapshot with a key
+ * key length is key size of hash saved, or strlen() for variable length keys
+ *
+ * @param snap snapshot
+ * @param key key to search with
+ * @return NULL when key is not found, pointer to read only element when found
+ */
+const void*
+lookupHashSnapshot(HashSnapshot* snap, const void* key)
+{
+   int len;
+
+   if(snap->header->key_flags & HASH_KEY_VARIABLE)
+   {
+      len = strlen((const char*)key);
+   }
+   else
+   {
+      len = snap->header->key_size;
+   }
+   return lookupHashSnapshotLen(snap, key, len);
+}
@@ -0,0 +1,78 @@
+//
+// a read only memory mapped image of hash
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __HASH_SNAPSHOT_DEF_H__
+#define __HASH_SNAPSHOT_DEF_H__
+
+#include <stdint.h>
+#include "hash.h"
+
+#define HASH_SNAPSHOT_MAGIC      0x50414e5348534148ull   /** "HASHSNAP" in host byte order */
+#define HASH_SNAPSHOT_VERSION    2
+
+/**
+ * snapshot file header
+ * everything after the header is located by offsets from file start,
+ * so the image can be mapped at any address
+ */
+typedef struct hash_snapshot_header
+{
+   uint64_t          magic;            /** HASH_SNAPSHOT_MAGIC                */
+   uint32_t          version;          /** HASH_SNAPSHOT_VERSION              */
+   uint32_t          key_flags;        /** key flags of hash saved            */
+   uint32_t          key_size;         /** key size for fixed size keys       */
+   uint32_t          elem_size;        /** size of each element saved         */
+   uint32_t          numBuckets;       /** number of buckets, power of 2      */
+   uint32_t          numElements;      /** number of elements                 */
+   uint32_t          hash_check;       /** hash function check value          */
+   uint32_t          reserved;
+   uint64_t          bucket_offset;    /** bucket index table                 */
+   uint64_t          entry_offset;     /** entry table                        */
+   uint64_t          key_region;       /** start of key bytes                 */
+   uint64_t          data_region;      /** start of element bytes             */
+   uint64_t          file_size;        /** total image size                   */
+} HashSnapshotHeader;
+
+/**
+ * an entry per element, sorted by bucket
+ */
+typedef struct hash_snapshot_entry
+{
+   uint32_t          hash_value;       /** hash value of key                  */
+   uint32_t          key_len;          /** key length                         */
+   uint64_t          key_offset;       /** key bytes                          */
+   uint64_t          data_offset;      /** element bytes                      */
+} HashSnapshotEntry;
+
+/**
+ * a hash snapshot mapped in memory
+ */
+typedef struct hash_snapshot
+{
+   char*                base;          /** mapped image                       */
+   size_t               size;          /** mapped size                        */
+   HashSnapshotHeader*  header;
+   uint32_t*            buckets;       /** bucket i has entries [buckets[i], buckets[i + 1]) */
+   HashSnapshotEntry*   entries;
+   hash_func            calc_hash;     /** hash function to use               */
+} HashSnapshot;
+
+extern int saveHashSnapshot(HashContext* hash, int elem_size, const char* path);
+extern int openHashSnapshot(HashSnapshot* snap, const char* path, hash_func func);
+extern void closeHashSnapshot(HashSnapshot* snap);
+extern const void* lookupHashSnapshot(HashSnapshot* snap, const void* key);
+extern const void* lookupHashSnapshotLen(HashSnapshot* snap, const void* key, int len);
+
+static inline int
+getHashSnapshotSize(HashSnapshot* snap)
+{
+   return snap->header->numElements;
+}
+
+#endif //!__HASH_SNAPSHOT_DEF_H__
@@ -8,112 +8,655 @@
 // 
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <poll.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <limits.h>
 #include "io_event_driver.h"
 
-typedef struct
+/**
+ * registrations of an fd
+ * slot table is indexed by fd so lookup is a plain array access
+ */
+typedef struct _io_driver_slot
+{
+   unsigned int         events;        /** bit mask of registered IOEventType */
+   io_event_callback    cb[3];         /** callbacks for RX/TX/Error          */
+   void*                priv[3];       /** callback parameters for RX/TX/Error */
+   unsigned int         gen;           /** io_uring poll generation of the fd  */
+   int                  armed;         /** 1 if io_uring poll is outstanding   */
+   int                  failed;        /** 1 if io_uring poll completed with an error */
+} IODriverSlot;
+
+/**
+ * io_uring instance with its SQ/CQ rings mapped
+ */
+typedef struct _io_driver_uring
 {
-   struct list_head     next;
-   int                  fd;
-   io_event_callback    cb;
-   void*                priv;
-} IODriverElement;
+   int                  fd;            /** io_uring fd                         */
+   void*                ring;          /** SQ/CQ ring mapping                  */
+   size_t               ring_size;     /** size of SQ/CQ ring mapping          */
+   struct io_uring_sqe* sqes;          /** submission queue entries            */
+   size_t               sqes_size;     /** size of submission queue entries    */
+   unsigned int*        sq_head;
+   unsigned int*        sq_tail;
+   unsigned int*        sq_array;
+   unsigned int         sq_mask;
+   unsigned int         sq_entries;
+   unsigned int*        cq_head;
+   unsigned int*        cq_tail;
+   unsigned int         cq_mask;
+   struct io_uring_cqe* cqes;
+   unsigned int         to_submit;     /** SQEs queued but not submitted yet   */
+   int                  rearm;         /** some registered fds are not armed   */
+} IODriverUring;
 
-#ifndef MAX
-#define MAX(a,b)  a >= b ? a : b
-#endif
+#define IO_DRIVER_MIN_SLOTS      64
+#define IO_DRIVER_MAX_EVENTS     256
+#define IO_DRIVER_URING_ENTRIES  256
+
+#define IO_EVENT_BIT(type)       (1 << (type))
+
+//
+// io_uring user_data is fd in lower 32 bits and poll generation in upper 32 bits
+// poll remove requests carry IO_URING_REMOVE_DATA and their completions are ignored
+//
+#define IO_URING_DATA(fd, gen)   (((unsigned long long)(gen) << 32) | (unsigned int)(fd))
+#define IO_URING_DATA_FD(data)   ((int)((data) & 0xffffffffULL))
+#define IO_URING_DATA_GEN(data)  ((unsigned int)((data) >> 32))
+#define IO_URING_REMOVE_DATA     (~0ULL)
+
+static const char* io_driver_wait_name[3] =
+{
+   "select:",           // IO_DRIVER_SELECT
+   "epoll_wait:",       // IO_DRIVER_EPOLL
+   "io_uring_enter:",   // IO_DRIVER_URING
+};
+
+//
+// epoll uses the same event bits as poll
+//
+static const unsigned int poll_event_bits[3] =
+{
+   POLLIN,        // IO_EVENT_RX
+   POLLOUT,       // IO_EVENT_TX
+   POLLPRI,       // IO_EVENT_ERROR
+};
 
 ////////////////////////////////////////////////////////////////////////////////
 //
 // static utilities
 //
 ////////////////////////////////////////////////////////////////////////////////
+static void
+crash(void)
+{
+   char* ptr = NULL;
+
+   *ptr = 0;
+}
+
+static inline IODriverSlot*
+get_io_event_slot(IOEventDriver* driver, int fd)
+{
+   if(fd < 0 || fd >= driver->num_slots)
+   {
+      return NULL;
+   }
+   return &driver->slots[fd];
+}
+
+static int
+grow_io_event_slots(IOEventDriver* driver, int fd)
+{
+   IODriverSlot*  slots;
+   int            num_slots;
+
+   num_slots = driver->num_slots == 0 ? IO_DRIVER_MIN_SLOTS : driver->num_slots;
+   while(num_slots <= fd)
+   {
+      num_slots *= 2;
+   }
+
+   slots = (IODriverSlot*)realloc(driver->slots, sizeof(IODriverSlot) * num_slots);
+   if(slots == NULL)
+   {
+      return -1;
+   }
+
+   memset(&slots[driver->num_slots], 0, sizeof(IODriverSlot) * (num_slots - driver->num_slots));
+
+   driver->slots     = slots;
+   driver->num_slots = num_slots;
+   return 0;
+}
+
+static inline unsigned int
+get_poll_events(unsigned int events)
+{
+   unsigned int   ev = 0;
+   int            type;
+
+   for(type = IO_EVENT_RX; type <= IO_EVENT_ERROR; type++)
+   {
+      if(events & IO_EVENT_BIT(type))
+      {
+         ev |= poll_event_bits[type];
+      }
+   }
+   return ev;
+}
+
+static int
+update_epoll_event(IOEventDriver* driver, int fd, unsigned int old, unsigned int new)
+{
+   struct epoll_event   ev;
+   int                  op;
+
+   if(old == 0)
+   {
+      op = EPOLL_CTL_ADD;
+   }
+   else if(new == 0)
+   {
+      op = EPOLL_CTL_DEL;
+   }
+   else
+   {
+      op = EPOLL_CTL_MOD;
+   }
+
+   ev.events   = get_poll_events(new);
+   ev.data.fd  = fd;
+
+   return epoll_ctl(driver->epoll_fd, op, fd, &ev);
+}
+
+static inline void
+dispatch_io_event(IOEventDriver* driver, int fd, IOEventType type);
+
+static inline void
+dispatch_poll_event(IOEventDriver* driver, int fd, unsigned int ev)
+{
+   //
+   // errors and hang up are reported to all the interested parties
+   // just like select reports the fd readable/writable
+   //
+   if(ev & (POLLIN | POLLERR | POLLHUP))
+   {
+      dispatch_io_event(driver, fd, IO_EVENT_RX);
+   }
+   if(ev & (POLLOUT | POLLERR | POLLHUP))
+   {
+      dispatch_io_event(driver, fd, IO_EVENT_TX);
+   }
+   if(ev & (POLLPRI | POLLERR | POLLHUP))
+   {
+      dispatch_io_event(driver, fd, IO_EVENT_ERROR);
+   }
+}
+
 static inline void
-free_io_event_list(struct list_head* head)
+dispatch_io_event(IOEventDriver* driver, int fd, IOEventType type)
 {
-   IODriverElement   *p, *n;
+   IODriverSlot*  slot;
 
-   list_for_each_entry_safe(p, n, head, next)
+   //
+   // a callback might have removed this registration or
+   // reallocated slot table. so always look it up again
+   //
+   slot = get_io_event_slot(driver, fd);
+   if(slot != NULL && slot->cb[type] != NULL)
    {
-      list_del_init(&p->next);
-      free(p);
+      slot->cb[type](driver, fd, type, slot->priv[type]);
    }
 }
 
+static int
+wait_epoll_event(IOEventDriver* driver, int timeout_usec)
+{
+   struct epoll_event   events[IO_DRIVER_MAX_EVENTS];
+   int                  ret,
+                        i;
+
+   ret = epoll_wait(driver->epoll_fd, events, IO_DRIVER_MAX_EVENTS,
+         timeout_usec < 0 ? -1 : (timeout_usec + 999) / 1000);
+   if(ret <= 0)
+   {
+      return ret;
+   }
+
+   for(i = 0; i < ret; i++)
+   {
+      dispatch_poll_event(driver, events[i].data.fd, events[i].events);
+   }
+   return ret;
+}
+
+static inline int
+io_uring_setup(unsigned int entries, struct io_uring_params* p)
+{
+   return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete,
+      unsigned int flags, void* arg, size_t argsz)
+{
+   return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
 static void
-crash(void)
+deinit_uring(IODriverUring* uring)
 {
-   char* ptr = NULL;
+   if(uring->sqes != NULL)
+   {
+      munmap(uring->sqes, uring->sqes_size);
+   }
+   if(uring->ring != NULL)
+   {
+      munmap(uring->ring, uring->ring_size);
+   }
+   if(uring->fd >= 0)
+   {
+      close(uring->fd);
+   }
+   free(uring);
+}
 
-   *ptr = 0;
+static IODriverUring*
+init_uring(void)
+{
+   IODriverUring*          uring;
+   struct io_uring_params  p;
+   size_t                  cq_size;
+   char*                   ring;
+
+   uring = (IODriverUring*)calloc(1, sizeof(IODriverUring));
+   if(uring == NULL)
+   {
+      return NULL;
+   }
+
+   memset(&p, 0, sizeof(p));
+
+   uring->fd = io_uring_setup(IO_DRIVER_URING_ENTRIES, &p);
+   if(uring->fd < 0)
+   {
+      free(uring);
+      return NULL;
+   }
+
+   //
+   // we need a timeout on io_uring_enter and no CQE drop on overflow
+   // kernels without them are left to epoll
+   //
+   if(!(p.features & IORING_FEAT_SINGLE_MMAP) ||
+      !(p.features & IORING_FEAT_NODROP) ||
+      !(p.features & IORING_FEAT_EXT_ARG))
+   {
+      deinit_uring(uring);
+      return NULL;
+   }
+
+   uring->ring_size  = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+   cq_size           = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+   if(cq_size > uring->ring_size)
+   {
+      uring->ring_size = cq_size;
+   }
+
+   uring->ring = mmap(NULL, uring->ring_size, PROT_READ | PROT_WRITE,
+         MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+   if(uring->ring == MAP_FAILED)
+   {
+      uring->ring = NULL;
+      deinit_uring(uring);
+      return NULL;
+   }
+
+   uring->sqes_size  = p.sq_entries * sizeof(struct io_uring_sqe);
+   uring->sqes       = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+         MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+   if(uring->sqes == MAP_FAILED)
+   {
+      uring->sqes = NULL;
+      deinit_uring(uring);
+      return NULL;
+   }
+
+   ring              = (char*)uring->ring;
+   uring->sq_head    = (unsigned int*)(ring + p.sq_off.head);
+   uring->sq_tail    = (unsigned int*)(ring + p.sq_off.tail);
+   uring->sq_array   = (unsigned int*)(ring + p.sq_off.array);
+   uring->sq_mask    = *(unsigned int*)(ring + p.sq_off.ring_mask);
+   uring->sq_entries = p.sq_entries;
+   uring->cq_head    = (unsigned int*)(ring + p.cq_off.head);
+   uring->cq_tail    = (unsigned int*)(ring + p.cq_off.tail);
+   uring->cq_mask    = *(unsigned int*)(ring + p.cq_off.ring_mask);
+   uring->cqes       = (struct io_uring_cqe*)(ring + p.cq_off.cqes);
+   uring->to_submit  = 0;
+   return uring;
+}
+
+static struct io_uring_sqe*
+get_uring_sqe(IODriverUring* uring)
+{
+   struct io_uring_sqe* sqe;
+   unsigned int         tail,
+                        head;
+
+   tail = *uring->sq_tail;
+   head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+
+   if(tail - head >= uring->sq_entries)
+   {
+      // SQ is full. push what we have so far to kernel
+      if(io_uring_enter(uring->fd, uring->to_submit, 0, 0, NULL, 0) < 0)
+      {
+         return NULL;
+      }
+
+      head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+      uring->to_submit = tail - head;
+      if(tail - head >= uring->sq_entries)
+      {
+         return NULL;
+      }
+   }
+
+   sqe = &uring->sqes[tail & uring->sq_mask];
+   memset(sqe, 0, sizeof(*sqe));
+
+   uring->sq_array[tail & uring->sq_mask] = tail & uring->sq_mask;
+   return sqe;
+}
+
+static inline void
+commit_uring_sqe(IODriverUring* uring)
+{
+   __atomic_store_n(uring->sq_tail, *uring->sq_tail + 1, __ATOMIC_RELEASE);
+   uring->to_submit++;
+}
+
+//
+// io_uring polls are one shot and re-armed after dispatch
+// so that readiness is level triggered just like select and epoll.
+// all the poll requests are submitted together in the next wait
+//
+static int
+arm_uring_poll(IOEventDriver* driver, int fd)
+{
+   IODriverSlot*        slot = &driver->slots[fd];
+   struct io_uring_sqe* sqe;
+
+   sqe = get_uring_sqe(driver->uring);
+   if(sqe == NULL)
+   {
+      // retried in the next wait
+      driver->uring->rearm = 1;
+      return -1;
+   }
+
+   slot->gen++;
+
+   sqe->opcode          = IORING_OP_POLL_ADD;
+   sqe->fd              = fd;
+   sqe->poll32_events   = get_poll_events(slot->events);
+   sqe->user_data       = IO_URING_DATA(fd, slot->gen);
+
+   commit_uring_sqe(driver->uring);
+   slot->armed    = 1;
+   slot->failed   = 0;
+   return 0;
+}
+
+static int
+disarm_uring_poll(IOEventDriver* driver, int fd)
+{
+   IODriverSlot*        slot = &driver->slots[fd];
+   struct io_uring_sqe* sqe;
+
+   if(!slot->armed)
+   {
+      return 0;
+   }
+
+   sqe = get_uring_sqe(driver->uring);
+   if(sqe == NULL)
+   {
+      return -1;
+   }
+
+   sqe->opcode          = IORING_OP_POLL_REMOVE;
+   sqe->fd              = -1;
+   sqe->addr            = IO_URING_DATA(fd, slot->gen);
+   sqe->user_data       = IO_URING_REMOVE_DATA;
+
+   commit_uring_sqe(driver->uring);
+
+   // any completion of the removed poll is stale from now on
+   slot->gen++;
+   slot->armed = 0;
+   return 0;
 }
 
-static inline IODriverElement*
-get_io_event_element(IOEventDriver* driver, IOEventType type, int fd)
+static int
+update_uring_event(IOEventDriver* driver, int fd, unsigned int events)
 {
-   IODriverElement*     p;
+   IODriverSlot*     slot = &driver->slots[fd];
+   unsigned int      old = slot->events;
+
+   if(disarm_uring_poll(driver, fd) != 0)
+   {
+      return -1;
+   }
 
-   list_for_each_entry(p, &driver->io_set[type], next)
+   slot->events = events;
+   if(events != 0 && arm_uring_poll(driver, fd) != 0)
    {
-      if(p->fd == fd)
+      //
+      // the old poll is gone already. the old registration is
+      // armed again in the next wait, so the fd is never left unpolled
+      //
+      slot->events = old;
+      return -1;
+   }
+   slot->failed = 0;
+   return 0;
+}
+
+//
+// arms the fds whose poll couldn't be submitted for lack of SQEs
+//
+static void
+rearm_uring_polls(IOEventDriver* driver)
+{
+   IODriverSlot*  slot;
+   int            fd;
+
+   driver->uring->rearm = 0;
+   for(fd = 0; fd <= driver->max_fd; fd++)
+   {
+      slot = &driver->slots[fd];
+      if(slot->events != 0 && !slot->armed && !slot->failed &&
+         arm_uring_poll(driver, fd) != 0)
       {
-         return p;
+         return;
       }
    }
+}
+
+static int
+wait_uring_event(IOEventDriver* driver, int timeout_usec)
+{
+   IODriverUring*                   uring = driver->uring;
+   struct io_uring_getevents_arg    arg;
+   struct __kernel_timespec         ts;
+   struct io_uring_cqe              cqe;
+   IODriverSlot*                    slot;
+   unsigned int                     head,
+                                    tail;
+   int                              ret,
+                                    fd,
+                                    count = 0;
+
+   ts.tv_sec      = timeout_usec / 1000000;
+   ts.tv_nsec     = (timeout_usec % 1000000) * 1000;
+
+   memset(&arg, 0, sizeof(arg));
+   if(timeout_usec >= 0)
+   {
+      arg.ts      = (unsigned long long)(unsigned long)&ts;
+   }
 
-   list_for_each_entry(p, &driver->working_set[type], next)
+   if(uring->rearm)
    {
-      if(p->fd == fd)
+      rearm_uring_polls(driver);
+   }
+
+   //
+   // submission of queued polls and wait for completions in one go.
+   // EBUSY and EAGAIN mean completions are backed up or the kernel is
+   // short of memory. nothing is submitted then, so reap the CQ to make
+   // room and let the next wait submit again instead of failing
+   //
+   ret = io_uring_enter(uring->fd, uring->to_submit, 1,
+         IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+   if(ret < 0 && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN)
+   {
+      return -1;
+   }
+   uring->to_submit = *uring->sq_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+
+   head = *uring->cq_head;
+   tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+   while(head != tail)
+   {
+      cqe = uring->cqes[head & uring->cq_mask];
+      head++;
+      __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+      if(cqe.user_data == IO_URING_REMOVE_DATA)
+      {
+         continue;
+      }
+
+      fd    = IO_URING_DATA_FD(cqe.user_data);
+      slot  = get_io_event_slot(driver, fd);
+      if(slot == NULL || !slot->armed || slot->gen != IO_URING_DATA_GEN(cqe.user_data))
+      {
+         continue;
+      }
+
+      slot->armed = 0;
+      count++;
+
+      //
+      // a failed poll, e.g. -EBADF after the fd is closed without unlisten,
+      // would fail again right away if re-armed. it is reported as an error
+      // and left disarmed until the fd is listened to again
+      //
+      if(cqe.res < 0)
+      {
+         slot->failed = 1;
+         dispatch_poll_event(driver, fd, POLLERR);
+      }
+      else if(cqe.res > 0)
+      {
+         dispatch_poll_event(driver, fd, cqe.res);
+      }
+
+      // the slot table might have been reallocated by callbacks
+      slot = &driver->slots[fd];
+      if(slot->events != 0 && !slot->armed && !slot->failed)
       {
-         return p;
+         arm_uring_poll(driver, fd);
       }
    }
-   return NULL;
+
+   if(count == 0 && ret < 0 && errno == EINTR)
+   {
+      return -1;
+   }
+   return count;
 }
 
 static inline int
 add_to_select_set(fd_set* set, IOEventDriver* driver, IOEventType type)
 {
-   IODriverElement*     p;
-   int                  not_empty = 0;
+   int   fd,
+         not_empty = 0;
 
-   list_for_each_entry(p, &driver->io_set[type], next)
+   for(fd = 0; fd <= driver->max_fd; fd++)
    {
-      FD_SET(p->fd, set);
-      driver->max_fd = MAX(driver->max_fd, p->fd);
-      not_empty = 1;
+      if(driver->slots[fd].events & IO_EVENT_BIT(type))
+      {
+         FD_SET(fd, set);
+         not_empty = 1;
+      }
    }
    return not_empty;
 }
 
 static inline void
-check_select(IOEventDriver* driver, fd_set* set, IOEventType type)
+check_select(IOEventDriver* driver, fd_set* set, IOEventType type, int max_fd)
 {
-   IODriverElement      *p, *n;
+   int   fd;
 
-   list_for_each_entry_safe(p, n, &driver->io_set[type], next)
+   for(fd = 0; fd <= max_fd; fd++)
    {
-      if(FD_ISSET(p->fd, set))
+      if(FD_ISSET(fd, set))
       {
-         list_del(&p->next);
-         list_add_tail(&p->next, &driver->working_set[type]);
+         dispatch_io_event(driver, fd, type);
       }
    }
+}
+
+static int
+wait_select_event(IOEventDriver* driver, int timeout_usec)
+{
+   fd_set            rset,
+                     tset,
+                     eset;
+   int               ret,
+                     r,
+                     w,
+                     e,
+                     max_fd = driver->max_fd;
+   struct timeval    to;
+
+   FD_ZERO(&rset);
+   FD_ZERO(&tset);
+   FD_ZERO(&eset);
+
+   r = add_to_select_set(&rset, driver, IO_EVENT_RX);
+   w = add_to_select_set(&tset, driver, IO_EVENT_TX);
+   e = add_to_select_set(&eset, driver, IO_EVENT_ERROR);
+
+   to.tv_sec      = timeout_usec / 1000000;
+   to.tv_usec     = timeout_usec % 1000000;
 
-   while(!list_empty(&driver->working_set[type]))
+   ret = select(max_fd + 1, r > 0 ? &rset : NULL, w > 0 ? &tset : NULL, e > 0 ? &eset : NULL,
+         timeout_usec < 0 ? NULL : &to);
+
+   if(ret <= 0)
    {
-       p = list_first_entry(&driver->working_set[type], IODriverElement, next);
-       list_del_init(&p->next);
-       list_add_tail(&p->next, &driver->io_set[type]);
-#if 0 // bug. 2014.mar.23
-      list_del(&p->next);
-      list_add_tail(&p->next, &driver->io_set[type]);
-#endif
-      p->cb(driver, p->fd, type, p->priv);
+      return ret;
    }
+
+   check_select(driver, &rset, IO_EVENT_RX, max_fd);
+   check_select(driver, &tset, IO_EVENT_TX, max_fd);
+   check_select(driver, &eset, IO_EVENT_ERROR, max_fd);
+   return ret;
 }
 
 static inline int
@@ -126,6 +669,35 @@ diff_time_in_usec(struct timeval* start, struct timeval* now)
 
    return diff < 0 ? 0 : diff;
 }
+
+static inline int
+get_io_event_timeout(IOEventDriver* driver, int remain)
+{
+   int   msec;
+
+   // timerfd wakes up the wait by itself
+   if(driver->timer == NULL || driver->timer_fd >= 0)
+   {
+      return remain;
+   }
+
+   msec = get_timer_timeout(driver->timer, remain < 0 ? -1 : (remain + 999) / 1000);
+   if(msec < 0)
+   {
+      return remain;
+   }
+
+   if(msec > INT_MAX / 1000)
+   {
+      msec = INT_MAX / 1000;
+   }
+
+   if(remain < 0 || msec * 1000 < remain)
+   {
+      return msec * 1000;
+   }
+   return remain;
+}
 ////////////////////////////////////////////////////////////////////////////////
 //
 // public utilities
@@ -133,6 +705,7 @@ diff_time_in_usec(struct timeval* start, struct timeval* now)
 ////////////////////////////////////////////////////////////////////////////////
 /**
  * initializes IO event driver
+ * epoll is used by default and select is used when epoll is not available
  *
  * @param driver IOEventDriver context block
  * @param poll_interval select poll interval in milliseconds
@@ -141,16 +714,62 @@ diff_time_in_usec(struct timeval* start, struct timeval* now)
 int
 init_io_event_driver(IOEventDriver* driver, int poll_interval)
 {
+   if(init_io_event_driver_mode(driver, poll_interval, IO_DRIVER_EPOLL) == 0)
+   {
+      return 0;
+   }
+   return init_io_event_driver_mode(driver, poll_interval, IO_DRIVER_SELECT);
+}
+
+/**
+ * initializes IO event driver with a given polling mechanism
+ * IO_DRIVER_URING falls back to IO_DRIVER_EPOLL when io_uring is not
+ * supported. driver->mode tells which one is actually in use
+ *
+ * @param driver IOEventDriver context block
+ * @param poll_interval select poll interval in milliseconds
+ * @param mode polling mechanism to use
+ * @return 0 on success, -1 on fail
+ */
+int
+init_io_event_driver_mode(IOEventDriver* driver, int poll_interval, IODriverMode mode)
+{
+   driver->mode            = mode;
    driver->poll_interval   = poll_interval;
-   driver->max_fd          = 0;
+   driver->max_fd          = -1;
+   driver->num_slots       = 0;
+   driver->slots           = NULL;
+   driver->epoll_fd        = -1;
+   driver->uring           = NULL;
+   driver->timer           = NULL;
+   driver->timer_fd        = -1;
 
-   INIT_LIST_HEAD(&driver->io_set[IO_EVENT_RX]);
-   INIT_LIST_HEAD(&driver->io_set[IO_EVENT_TX]);
-   INIT_LIST_HEAD(&driver->io_set[IO_EVENT_ERROR]);
+   //
+   // io_uring falls back to epoll when the kernel lacks support
+   //
+   if(mode == IO_DRIVER_URING)
+   {
+      driver->uring = init_uring();
+      if(driver->uring == NULL)
+      {
+         return init_io_event_driver_mode(driver, poll_interval, IO_DRIVER_EPOLL);
+      }
+   }
+
+   if(mode == IO_DRIVER_EPOLL)
+   {
+      driver->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+      if(driver->epoll_fd < 0)
+      {
+         return -1;
+      }
+   }
 
-   INIT_LIST_HEAD(&driver->working_set[IO_EVENT_RX]);
-   INIT_LIST_HEAD(&driver->working_set[IO_EVENT_TX]);
-   INIT_LIST_HEAD(&driver->working_set[IO_EVENT_ERROR]);
+   if(grow_io_event_slots(driver, IO_DRIVER_MIN_SLOTS - 1) != 0)
+   {
+      deinit_io_event_driver(driver);
+      return -1;
+   }
    return 0;
 }
 
@@ -162,13 +781,22 @@ init_io_event_driver(IOEventDriver* driver, int poll_interval)
 void
 deinit_io_event_driver(IOEventDriver* driver)
 {
-   free_io_event_list(&driver->io_set[IO_EVENT_RX]);
-   free_io_event_list(&driver->io_set[IO_EVENT_TX]);
-   free_io_event_list(&driver->io_set[IO_EVENT_ERROR]);
+   free(driver->slots);
+   driver->slots     = NULL;
+   driver->num_slots = 0;
+   driver->max_fd    = -1;
+
+   if(driver->epoll_fd >= 0)
+   {
+      close(driver->epoll_fd);
+      driver->epoll_fd = -1;
+   }
 
-   free_io_event_list(&driver->working_set[IO_EVENT_RX]);
-   free_io_event_list(&driver->working_set[IO_EVENT_TX]);
-   free_io_event_list(&driver->working_set[IO_EVENT_ERROR]);
+   if(driver->uring != NULL)
+   {
+      deinit_uring(driver->uring);
+      driver->uring = NULL;
+   }
 }
 
 /**
@@ -184,28 +812,45 @@ deinit_io_event_driver(IOEventDriver* driver)
 int
 listen_io_event(IOEventDriver* driver, int fd, IOEventType type, io_event_callback cb, void* priv)
 {
-   IODriverElement*     element;
-
-   element = get_io_event_element(driver, type, fd);
+   IODriverSlot*     slot;
+   unsigned int      events;
 
-   if(element != NULL)
+   if(fd < 0 || (driver->mode == IO_DRIVER_SELECT && fd >= FD_SETSIZE))
    {
-      element->cb    = cb;
-      element->priv  = priv;
-      return 0;
+      return -1;
    }
 
-   element = (IODriverElement*)malloc(sizeof(IODriverElement));
-   if(element == NULL)
+   if(fd >= driver->num_slots && grow_io_event_slots(driver, fd) != 0)
    {
       return -1;
    }
 
-   element->fd    = fd;
-   element->cb    = cb;
-   element->priv  = priv;
+   slot     = &driver->slots[fd];
+   events   = slot->events | IO_EVENT_BIT(type);
 
-   list_add_tail(&element->next, &driver->io_set[type]);
+   if(driver->mode == IO_DRIVER_EPOLL && events != slot->events)
+   {
+      if(update_epoll_event(driver, fd, slot->events, events) != 0)
+      {
+         return -1;
+      }
+   }
+   else if(driver->mode == IO_DRIVER_URING && (events != slot->events || slot->failed))
+   {
+      if(update_uring_event(driver, fd, events) != 0)
+      {
+         return -1;
+      }
+   }
+
+   slot->events      = events;
+   slot->cb[type]    = cb;
+   slot->priv[type]  = priv;
+
+   if(fd > driver->max_fd)
+   {
+      driver->max_fd = fd;
+   }
    return 0;
 }
 
@@ -220,85 +865,138 @@ listen_io_event(IOEventDriver* driver, int fd, IOEventType type, io_event_callba
 int
 unlisten_io_event(IOEventDriver* driver, int fd, IOEventType type)
 {
-   IODriverElement*     element;
+   IODriverSlot*     slot;
+   unsigned int      events;
 
-   element = get_io_event_element(driver, type, fd);
+   slot = get_io_event_slot(driver, fd);
+   if(slot == NULL || !(slot->events & IO_EVENT_BIT(type)))
+   {
+      return -1;
+   }
 
-   if(element == NULL)
+   events = slot->events & ~IO_EVENT_BIT(type);
+
+   if(driver->mode == IO_DRIVER_EPOLL)
+   {
+      // the fd might already be closed by the caller, so ignore the result
+      update_epoll_event(driver, fd, slot->events, events);
+   }
+   else if(driver->mode == IO_DRIVER_URING && update_uring_event(driver, fd, events) != 0)
    {
       return -1;
    }
 
-   list_del_init(&element->next);
-   free(element);
+   slot->events      = events;
+   slot->cb[type]    = NULL;
+   slot->priv[type]  = NULL;
 
+   while(driver->max_fd >= 0 && driver->slots[driver->max_fd].events == 0)
+   {
+      driver->max_fd--;
+   }
    return 0;
 }
 
+static void
+timer_fd_event(IOEventDriver* driver, int fd, IOEventType type, void* priv)
+{
+   drive_timer((Timer*)priv);
+}
+
+//
+// keeps the attached timer's timerfd listened to.
+// enable_timer_fd() can be called before or after the timer is attached,
+// so this is checked on every drive. while the fd is not listened to,
+// the driver bounds the wait and drives the timer by itself
+//
+static void
+sync_timer_fd(IOEventDriver* driver)
+{
+   if(driver->timer_fd >= 0)
+   {
+      unlisten_io_event(driver, driver->timer_fd, IO_EVENT_RX);
+      driver->timer_fd = -1;
+   }
+
+   if(driver->timer != NULL && driver->timer->fd >= 0 &&
+      listen_io_event(driver, driver->timer->fd, IO_EVENT_RX, timer_fd_event, driver->timer) == 0)
+   {
+      driver->timer_fd = driver->timer->fd;
+   }
+}
+
 /**
  * drives IO event driver
  *
- * a) set up select timer and fd sets
- * b) enter select
+ * a) set up poll timer and fd sets
+ * b) enter select, epoll_wait or io_uring_enter
  * c) handle IO events 
+ * d) handle timer expiries if a timer is attached
+ *
+ * with a timer attached, the wait is cut short at the next timer expiry
+ * and negative poll interval blocks until an IO event or a timer expiry
  *
  * @param driver IOEventDriver context block
  */
 void
 drive_io_event(IOEventDriver* driver)
 {
-   fd_set            rset,
-                     tset,
-                     eset;
    int               ret,
-                     r,
-                     w,
-                     e,
+                     timeout,
                      original = driver->poll_interval * 1000,
                      remain  = original;
-   struct timeval    to,
-                     start,
+   struct timeval    start,
                      now;
 
-   gettimeofday(&start, NULL);
-loop:
-   FD_ZERO(&rset);
-   FD_ZERO(&tset);
-   FD_ZERO(&eset);
-
-   driver->max_fd = 0;
+   if(original < 0)
+   {
+      original = remain = -1;
+   }
 
-   r = add_to_select_set(&rset, driver, IO_EVENT_RX);
-   w = add_to_select_set(&tset, driver, IO_EVENT_TX);
-   e = add_to_select_set(&eset, driver, IO_EVENT_ERROR);
+   if(driver->timer != NULL && driver->timer->fd != driver->timer_fd)
+   {
+      sync_timer_fd(driver);
+   }
 
-   to.tv_sec      = 0;
-   //to.tv_usec     = driver->poll_interval * 1000;  // in micro second unit
-   to.tv_usec     = remain;
+   gettimeofday(&start, NULL);
+loop:
+   timeout = get_io_event_timeout(driver, remain);
 
-   ret = select(driver->max_fd + 1, r > 0 ? &rset : NULL, w > 0 ? &tset : NULL, e > 0 ? &eset : NULL, &to);
+   if(driver->mode == IO_DRIVER_EPOLL)
+   {
+      ret = wait_epoll_event(driver, timeout);
+   }
+   else if(driver->mode == IO_DRIVER_URING)
+   {
+      ret = wait_uring_event(driver, timeout);
+   }
+   else
+   {
+      ret = wait_select_event(driver, timeout);
+   }
 
-   if(ret == 0)
+   if(driver->timer != NULL && driver->timer_fd < 0)
    {
-      return;
+      drive_timer(driver->timer);
    }
 
    if(ret == -1)
    {
       if(errno != EINTR)
       {
-         perror("select:");
+         perror(io_driver_wait_name[driver->mode]);
          crash();
       }
       return;
    }
 
-   check_select(driver, &rset, IO_EVENT_RX);
-   check_select(driver, &tset, IO_EVENT_TX);
-   check_select(driver, &eset, IO_EVENT_ERROR);
+   if(original < 0 || (ret == 0 && timeout == remain))
+   {
+      return;
+   }
 
    gettimeofday(&now, NULL);
-   remain -= diff_time_in_usec(&start, &now);
+   remain = original - diff_time_in_usec(&start, &now);
 
    if(remain > original || remain < 30)
    {
@@ -306,3 +1004,30 @@ loop:
    }
    goto loop;
 }
+
+/**
+ * attach a timer to IO event driver
+ * from then on, the driver waits no longer than the next timer expiry
+ * and drives the timer in drive_io_event(). caller must not call drive_timer()
+ * when timerfd is enabled on the timer with enable_timer_fd(),
+ * the fd is listened to instead and the timer is driven only when it expires.
+ * timerfd can be enabled before or after attaching. when enabled afterwards,
+ * the fd is picked up at the next drive_io_event()
+ *
+ * @param driver IOEventDriver context block
+ * @param timer initialized timer manager, or NULL to detach
+ * @return 0 on success, -1 on failure
+ */
+int
+set_io_event_timer(IOEventDriver* driver, Timer* timer)
+{
+   driver->timer = timer;
+   sync_timer_fd(driver);
+
+   if(timer != NULL && timer->fd >= 0 && driver->timer_fd < 0)
+   {
+      driver->timer = NULL;
+      return -1;
+   }
+   return 0;
+}
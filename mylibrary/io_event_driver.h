@@ -22,15 +22,33 @@ typedef enum
    IO_EVENT_ERROR,      /** Error or Exceptional case */
 } IOEventType;
 
+/**
+ * polling mechanism used by IO Event Driver
+ */
+typedef enum
+{
+   IO_DRIVER_SELECT = 0,   /** select(2), limited to FD_SETSIZE fds         */
+   IO_DRIVER_EPOLL,        /** epoll(7), registrations are kept in kernel  */
+   IO_DRIVER_URING,        /** io_uring(7), polls are submitted in batch   */
+} IODriverMode;
+
+struct _io_driver_slot;
+struct _io_driver_uring;
+
 /**
  * IO Event Driver Control Block
  */
 typedef struct
 {
-   int               poll_interval;    /** poll interval for select call         */
-   int               max_fd;           /** maximum fd value calculated per loop  */
-   struct list_head  io_set[3];        /** registered IO events for RX/TX/Error  */
-   struct list_head  working_set[3];
+   IODriverMode            mode;             /** polling mechanism in use                 */
+   int                     poll_interval;    /** poll interval for select call            */
+   int                     max_fd;           /** maximum registered fd, -1 if none        */
+   int                     num_slots;        /** size of fd indexed slot table            */
+   struct _io_driver_slot* slots;            /** registrations indexed by fd              */
+   int                     epoll_fd;         /** epoll instance for IO_DRIVER_EPOLL       */
+   struct _io_driver_uring* uring;           /** io_uring instance for IO_DRIVER_URING    */
+   Timer*                  timer;            /** timer driven by this driver, or NULL     */
+   int                     timer_fd;         /** timerfd of timer listened to, -1 if none */
 } IOEventDriver;
 
 /**
@@ -39,9 +57,11 @@ typedef struct
 typedef void (*io_event_callback)(IOEventDriver* driver, int fd, IOEventType type, void* priv);
 
 extern int init_io_event_driver(IOEventDriver* driver, int poll_interval);
+extern int init_io_event_driver_mode(IOEventDriver* driver, int poll_interval, IODriverMode mode);
 extern void deinit_io_event_driver(IOEventDriver* driver);
 extern int listen_io_event(IOEventDriver* driver, int fd, IOEventType type, io_event_callback cb, void* priv);
 extern int unlisten_io_event(IOEventDriver* driver, int fd, IOEventType type);
 extern void drive_io_event(IOEventDriver* driver);
+extern int set_io_event_timer(IOEventDriver* driver, Timer* timer);
 
 #endif //!__IO_EVENT_DRIVER_DEF_H__
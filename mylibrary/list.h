@@ -15,7 +15,7 @@
       const typeof( ((type *)0)->member ) *__mptr = (ptr);    \
       (type *)( (char *)__mptr - offsetof(type,member) );})
 
-#define prefetch(__x__) (__x__ = __x__)
+#define prefetch(__x__) __builtin_prefetch(__x__)
 
 /*
  * Simple doubly linked list implementation.
@@ -578,6 +578,113 @@ static inline void list_splice_tail_init(struct list_head *list,
 #define list_safe_reset_next(pos, n, member)				\
 	n = list_entry(pos->member.next, typeof(*pos), member)
 
+/*
+ * RCU variants of list operations.
+ *
+ * Readers may walk a list with list_for_each_rcu() and friends without
+ * any lock while a single writer (serialized by the caller) modifies it.
+ * Only ->next is followed by readers, so writers publish an entry with a
+ * release store after it is fully initialized, and a deleted entry keeps
+ * its ->next so that readers standing on it can move on. A deleted entry
+ * must not be freed or reused until all readers that might see it are gone.
+ */
+
+/**
+ * rcu_assign_pointer - publish a pointer to readers
+ * @param p: pointer to assign to
+ * @param v: value to assign, fully initialized before this
+ */
+#define rcu_assign_pointer(p, v) \
+	__atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+/**
+ * rcu_dereference - fetch a pointer published by rcu_assign_pointer()
+ * @param p: pointer to read
+ */
+#define rcu_dereference(p) \
+	__atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+
+static inline void __list_add_rcu(struct list_head *new,
+		struct list_head *prev, struct list_head *next)
+{
+	new->next = next;
+	new->prev = prev;
+	rcu_assign_pointer(prev->next, new);
+	next->prev = new;
+}
+
+/**
+ * list_add_rcu - add a new entry to rcu protected list
+ * @param new: new entry to be added
+ * @param head: list head to add it after
+ */
+static inline void list_add_rcu(struct list_head *new, struct list_head *head)
+{
+	__list_add_rcu(new, head, head->next);
+}
+
+/**
+ * list_add_tail_rcu - add a new entry to the tail of rcu protected list
+ * @param new: new entry to be added
+ * @param head: list head to add it before
+ */
+static inline void list_add_tail_rcu(struct list_head *new,
+					struct list_head *head)
+{
+	__list_add_rcu(new, head->prev, head);
+}
+
+/**
+ * list_del_rcu - deletes entry from rcu protected list
+ * @param entry: the element to delete from the list.
+ *
+ * ->next is left intact for readers still on the entry.
+ * list_empty() on entry does not return true after this.
+ */
+static inline void list_del_rcu(struct list_head *entry)
+{
+	entry->next->prev = entry->prev;
+	rcu_assign_pointer(entry->prev->next, entry->next);
+	entry->prev = NULL;
+}
+
+/**
+ * list_replace_rcu - replace old entry by new one in rcu protected list
+ * @param old : the element to be replaced
+ * @param new : the new element to insert
+ *
+ * readers see either old or new, never neither.
+ */
+static inline void list_replace_rcu(struct list_head *old,
+					struct list_head *new)
+{
+	new->next = old->next;
+	new->prev = old->prev;
+	rcu_assign_pointer(new->prev->next, new);
+	new->next->prev = new;
+	old->prev = NULL;
+}
+
+/**
+ * list_for_each_rcu	-	iterate over rcu protected list
+ * @param pos:	the &struct list_head to use as a loop cursor.
+ * @param head:	the head for your list.
+ */
+#define list_for_each_rcu(pos, head) \
+	for (pos = rcu_dereference((head)->next); pos != (head); \
+		pos = rcu_dereference(pos->next))
+
+/**
+ * list_for_each_entry_rcu	-	iterate over rcu protected list of given type
+ * @param pos:	the type * to use as a loop cursor.
+ * @param head:	the head for your list.
+ * @param member:	the name of the list_struct within the struct.
+ */
+#define list_for_each_entry_rcu(pos, head, member)				\
+	for (pos = list_entry(rcu_dereference((head)->next), typeof(*pos), member); \
+	     &pos->member != (head);					\
+	     pos = list_entry(rcu_dereference(pos->member.next), typeof(*pos), member))
+
 /*
  * Double linked lists with a single pointer list head.
  * Mostly useful for hash tables where the two pointer list head is
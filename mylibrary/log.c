@@ -11,6 +11,9 @@
 #include <time.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
 
 #include "log.h"
 #include "list.h"
@@ -23,6 +26,52 @@ static FILE    *errorFile = NULL;
 static FILE    *messageFile = NULL;
 static int     flags = 0;
 
+//
+// async logging
+//
+// callers format messages into a bounded lock free queue of fixed size slots
+// (multi producer/single consumer, sequence number per slot) and a writer
+// thread writes them out in batch, flushing only when the queue runs dry.
+// callers hold a reference while touching the queue, so that logStopAsync()
+// waits them out before the slots are freed.
+//
+
+typedef struct
+{
+   unsigned long  seq;                       /** slot sequence number            */
+   FILE*          where;                     /** file to write the message to    */
+   int            len;                       /** message length                  */
+   char           msg[LOG_ASYNC_MSG_SIZE];   /** formatted message               */
+} LogSlot;
+
+typedef struct
+{
+   int               running;          /** 1 when async logging is on               */
+   int               stop;             /** tells writer thread to exit              */
+   int               policy;           /** LOG_OVERFLOW_DROP or LOG_OVERFLOW_BLOCK  */
+   unsigned long     mask;             /** number of slots - 1                      */
+   LogSlot*          slots;            /** message slots                            */
+   unsigned long     enqueuePos;       /** next slot to reserve by callers          */
+   unsigned long     dequeuePos;       /** next slot to write by writer thread      */
+   unsigned long     flushedPos;       /** messages before this are flushed         */
+   unsigned long     drops;            /** number of dropped messages               */
+   unsigned long     truncated;        /** number of truncated messages             */
+   int               users;            /** callers queueing a message right now     */
+   int               sleeping;         /** writer thread is waiting for messages    */
+   pthread_t         writer;
+   pthread_mutex_t   lock;
+   pthread_cond_t    wakeup;           /** wakes writer thread up                   */
+   pthread_cond_t    flushed;          /** signaled when writer thread flushed      */
+} LogAsync;
+
+static LogAsync   logAsync =
+{
+   .running = 0,
+   .lock    = PTHREAD_MUTEX_INITIALIZER,
+   .wakeup  = PTHREAD_COND_INITIALIZER,
+   .flushed = PTHREAD_COND_INITIALIZER,
+};
+
 /**
  * set a new log leven
  *
@@ -104,6 +153,335 @@ logClearFlags(int newFlags)
    flags &= ~newFlags;
 }
 
+static void
+wakeupLogWriter(void)
+{
+   if(__atomic_load_n(&logAsync.sleeping, __ATOMIC_SEQ_CST))
+   {
+      pthread_mutex_lock(&logAsync.lock);
+      pthread_cond_signal(&logAsync.wakeup);
+      pthread_mutex_unlock(&logAsync.lock);
+   }
+}
+
+static inline int
+isLogSlotReady(unsigned long pos)
+{
+   LogSlot* slot = &logAsync.slots[pos & logAsync.mask];
+
+   return __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == pos + 1;
+}
+
+static void*
+logWriterThread(void* arg)
+{
+   LogSlot*       slot;
+   FILE*          last = NULL;
+
+   for(;;)
+   {
+      while(isLogSlotReady(logAsync.dequeuePos))
+      {
+         slot = &logAsync.slots[logAsync.dequeuePos & logAsync.mask];
+
+         if(last != NULL && last != slot->where)
+         {
+            fflush(last);
+         }
+         last = slot->where;
+
+         fwrite(slot->msg, 1, slot->len, slot->where);
+
+         // hand the slot back to callers for the next round
+         __atomic_store_n(&slot->seq, logAsync.dequeuePos + logAsync.mask + 1, __ATOMIC_RELEASE);
+         logAsync.dequeuePos++;
+      }
+
+      // queue is empty. now is the time to flush
+      if(last != NULL)
+      {
+         fflush(last);
+         last = NULL;
+      }
+
+      pthread_mutex_lock(&logAsync.lock);
+
+      logAsync.flushedPos = logAsync.dequeuePos;
+      pthread_cond_broadcast(&logAsync.flushed);
+
+      __atomic_store_n(&logAsync.sleeping, 1, __ATOMIC_SEQ_CST);
+      if(!isLogSlotReady(logAsync.dequeuePos))
+      {
+         if(logAsync.stop)
+         {
+            logAsync.sleeping = 0;
+            pthread_mutex_unlock(&logAsync.lock);
+            break;
+         }
+         pthread_cond_wait(&logAsync.wakeup, &logAsync.lock);
+      }
+      __atomic_store_n(&logAsync.sleeping, 0, __ATOMIC_SEQ_CST);
+
+      pthread_mutex_unlock(&logAsync.lock);
+   }
+   return NULL;
+}
+
+//
+// reserves a slot and formats the message into it
+// returns 0 when the message is queued, -1 when dropped
+//
+static int
+logMessageAsync(FILE* where, char* format, va_list args)
+{
+   unsigned long  pos,
+                  seq;
+   long           diff;
+   LogSlot*       slot;
+   int            len = 0;
+
+   pos = __atomic_load_n(&logAsync.enqueuePos, __ATOMIC_RELAXED);
+   for(;;)
+   {
+      slot = &logAsync.slots[pos & logAsync.mask];
+      seq  = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+      diff = (long)seq - (long)pos;
+
+      if(diff == 0)
+      {
+         if(__atomic_compare_exchange_n(&logAsync.enqueuePos, &pos, pos + 1, 1,
+                  __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+         {
+            break;
+         }
+      }
+      else if(diff < 0)
+      {
+         // queue is full
+         if(logAsync.policy == LOG_OVERFLOW_DROP)
+         {
+            __atomic_fetch_add(&logAsync.drops, 1, __ATOMIC_RELAXED);
+            return -1;
+         }
+         wakeupLogWriter();
+         sched_yield();
+         pos = __atomic_load_n(&logAsync.enqueuePos, __ATOMIC_RELAXED);
+      }
+      else
+      {
+         pos = __atomic_load_n(&logAsync.enqueuePos, __ATOMIC_RELAXED);
+      }
+   }
+
+   if ((flags & LOG_TIMES))
+   {
+      len = snprintf(slot->msg, LOG_ASYNC_MSG_SIZE, "%ld:", (long) time(NULL));
+   }
+   len += vsnprintf(&slot->msg[len], LOG_ASYNC_MSG_SIZE - len, format, args);
+   if(len >= LOG_ASYNC_MSG_SIZE)
+   {
+      __atomic_fetch_add(&logAsync.truncated, 1, __ATOMIC_RELAXED);
+      len = LOG_ASYNC_MSG_SIZE - 1;
+   }
+
+   slot->where = where;
+   slot->len   = len;
+
+   // publish the message and make sure writer thread sees it
+   __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   wakeupLogWriter();
+   return 0;
+}
+
+//
+// takes a reference to the queue. fails when async logging is stopped
+// or being stopped. running and users are checked against each other
+// in the reverse order by logStopAsync(), so either side sees the other
+//
+static int
+logGetAsync(void)
+{
+   __atomic_fetch_add(&logAsync.users, 1, __ATOMIC_SEQ_CST);
+   if(!__atomic_load_n(&logAsync.running, __ATOMIC_SEQ_CST))
+   {
+      __atomic_fetch_sub(&logAsync.users, 1, __ATOMIC_SEQ_CST);
+      return -1;
+   }
+   return 0;
+}
+
+static inline void
+logPutAsync(void)
+{
+   __atomic_fetch_sub(&logAsync.users, 1, __ATOMIC_RELEASE);
+}
+
+static void
+logStopAsyncAtExit(void)
+{
+   logStopAsync();
+}
+
+/**
+ * starts asynchronous logging
+ * from then on, logMessage() queues messages and a writer thread writes
+ * them out. MESS_FATAL and MESS_CRASH messages are written synchronously
+ * after everything queued before them is flushed.
+ * queued messages longer than LOG_ASYNC_MSG_SIZE - 1 are truncated
+ * and counted in logGetTruncateCount()
+ *
+ * @param queueSize number of messages that can be queued, rounded up to power of 2
+ * @param overflowPolicy LOG_OVERFLOW_DROP or LOG_OVERFLOW_BLOCK
+ * @return 0 on success, -1 on failure
+ */
+int
+logStartAsync(int queueSize, int overflowPolicy)
+{
+   static int     atExitRegistered = 0;
+   unsigned long  size = 2,
+                  i;
+
+   if(logAsync.running)
+   {
+      return -1;
+   }
+
+   while(size < (unsigned long)queueSize)
+   {
+      size <<= 1;
+   }
+
+   logAsync.slots = (LogSlot*)malloc(sizeof(LogSlot) * size);
+   if(logAsync.slots == NULL)
+   {
+      return -1;
+   }
+
+   for(i = 0; i < size; i++)
+   {
+      logAsync.slots[i].seq = i;
+   }
+
+   logAsync.mask        = size - 1;
+   logAsync.policy      = overflowPolicy;
+   logAsync.enqueuePos  = 0;
+   logAsync.dequeuePos  = 0;
+   logAsync.flushedPos  = 0;
+   logAsync.drops       = 0;
+   logAsync.truncated   = 0;
+   logAsync.sleeping    = 0;
+   logAsync.stop        = 0;
+
+   if(errorFile == NULL)
+   {
+      errorFile = stderr;
+   }
+
+   if(messageFile == NULL)
+   {
+      messageFile = stderr;
+   }
+
+   if(pthread_create(&logAsync.writer, NULL, logWriterThread, NULL) != 0)
+   {
+      free(logAsync.slots);
+      logAsync.slots = NULL;
+      return -1;
+   }
+
+   if(!atExitRegistered)
+   {
+      atexit(logStopAsyncAtExit);
+      atExitRegistered = 1;
+   }
+
+   __atomic_store_n(&logAsync.running, 1, __ATOMIC_RELEASE);
+   return 0;
+}
+
+/**
+ * stops asynchronous logging
+ * all the queued messages are written out before it returns.
+ * callers logging meanwhile either get their message queued before
+ * the writer thread stops or write it synchronously
+ */
+void
+logStopAsync(void)
+{
+   if(!logAsync.running)
+   {
+      return;
+   }
+
+   __atomic_store_n(&logAsync.running, 0, __ATOMIC_SEQ_CST);
+
+   // callers past the running check are still writing to the slots
+   while(__atomic_load_n(&logAsync.users, __ATOMIC_SEQ_CST) != 0)
+   {
+      wakeupLogWriter();
+      sched_yield();
+   }
+
+   pthread_mutex_lock(&logAsync.lock);
+   logAsync.stop = 1;
+   pthread_cond_signal(&logAsync.wakeup);
+   pthread_mutex_unlock(&logAsync.lock);
+
+   pthread_join(logAsync.writer, NULL);
+
+   free(logAsync.slots);
+   logAsync.slots = NULL;
+}
+
+/**
+ * waits until all the messages queued so far are written and flushed
+ * it does nothing when async logging is off
+ */
+void
+logFlush(void)
+{
+   unsigned long target;
+
+   if(!__atomic_load_n(&logAsync.running, __ATOMIC_ACQUIRE))
+   {
+      return;
+   }
+
+   target = __atomic_load_n(&logAsync.enqueuePos, __ATOMIC_ACQUIRE);
+
+   pthread_mutex_lock(&logAsync.lock);
+   while((long)(logAsync.flushedPos - target) < 0)
+   {
+      pthread_cond_signal(&logAsync.wakeup);
+      pthread_cond_wait(&logAsync.flushed, &logAsync.lock);
+   }
+   pthread_mutex_unlock(&logAsync.lock);
+}
+
+/**
+ * gets the number of messages dropped by async logging queue overflow
+ *
+ * @return number of dropped messages
+ */
+unsigned long
+logGetDropCount(void)
+{
+   return __atomic_load_n(&logAsync.drops, __ATOMIC_RELAXED);
+}
+
+/**
+ * gets the number of messages truncated to LOG_ASYNC_MSG_SIZE by async logging
+ *
+ * @return number of truncated messages
+ */
+unsigned long
+logGetTruncateCount(void)
+{
+   return __atomic_load_n(&logAsync.truncated, __ATOMIC_RELAXED);
+}
+
 /**
  * logs a log message with level and format
  *
@@ -117,6 +495,8 @@ logClearFlags(int newFlags)
  * c) if LOG_TIMES flag is set, it prepends time before the message
  * d) for MESS_CRASH level, it crashes the currently logging process
  * e) for MESS_FATAL level, it exits the currently logging process with exit value 1
+ * f) with async logging on, the message is queued to writer thread
+ *    except for MESS_CRASH and MESS_FATAL
  *
  * @param level log leven desired
  * @param format message format
@@ -158,6 +538,27 @@ logMessage(int level, char *format, ...)
          where = errorFile;
          break;
       }
+
+      if(__atomic_load_n(&logAsync.running, __ATOMIC_ACQUIRE))
+      {
+         if(level != MESS_CRASH && level != MESS_FATAL)
+         {
+            // stopped in the meantime. write it synchronously
+            if(logGetAsync() == 0)
+            {
+               va_start(args, format);
+               logMessageAsync(where, format, args);
+               va_end(args);
+               logPutAsync();
+               return;
+            }
+         }
+         else
+         {
+            // everything before this must be out before we die
+            logFlush();
+         }
+      }
       
       if ((flags & LOG_TIMES))
       {
@@ -23,6 +23,17 @@
 
 #define LOG_TIMES	(1 << 0)
 
+/**
+ * async log queue overflow policy
+ */
+#define LOG_OVERFLOW_DROP        0        /** drop the message and count it      */
+#define LOG_OVERFLOW_BLOCK       1        /** wait for writer thread to catch up */
+
+/**
+ * async log messages longer than this including the time prefix are truncated
+ */
+#define LOG_ASYNC_MSG_SIZE       512
+
 extern void logMessage(int level, char *format, ...);
 
 extern void logSetErrorFile(FILE * f);
@@ -33,4 +44,10 @@ extern void logSetLevel(int level);
 extern FILE* logGetErrorFile(void);
 extern FILE* logGetMessageFile(void);
 
+extern int logStartAsync(int queueSize, int overflowPolicy);
+extern void logStopAsync(void);
+extern void logFlush(void);
+extern unsigned long logGetDropCount(void);
+extern unsigned long logGetTruncateCount(void);
+
 #endif //!__LOG_DEF_H__
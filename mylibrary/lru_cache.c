@@ -0,0 +1,196 @@
+//
+// a bounded key to object cache with LRU eviction
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include "lru_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+static inline LRUCacheElement*
+getCacheElement(LRUCache* cache, void* element)
+{
+   return (LRUCacheElement*)((char*)element + cache->elem_offset);
+}
+
+static inline void*
+getElementFromLRU(LRUCache* cache, struct list_head* lru)
+{
+   return (char*)list_entry(lru, LRUCacheElement, lru) - cache->elem_offset;
+}
+
+static void
+unlinkElement(LRUCache* cache, void* element)
+{
+   delHashElement(&cache->hash, element);
+   list_del_init(&getCacheElement(cache, element)->lru);
+}
+
+static void
+evictElement(LRUCache* cache, void* element)
+{
+   unlinkElement(cache, element);
+   if(cache->evict != NULL)
+   {
+      cache->evict(cache, element, cache->priv);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * initialize a LRU cache
+ *
+ * @param cache LRU cache
+ * @param capacity max number of objects to keep
+ * @param elem_offset offset of LRUCacheElement in cached object
+ * @param key_offset offset of key in cached object
+ * @param key_size size of key
+ * @param func hash function to use, use default if NULL
+ * @param evict callback for objects leaving cache, can be NULL
+ * @param priv private argument for evict callback
+ */
+void
+initLRUCache(LRUCache* cache, int capacity, int elem_offset,
+      int key_offset, int key_size, hash_func func, lru_evict_func evict, void* priv)
+{
+   initHash(&cache->hash, capacity, elem_offset + offsetof(LRUCacheElement, he),
+         key_offset, key_size, func);
+   INIT_LIST_HEAD(&cache->lru);
+
+   cache->capacity      = capacity;
+   cache->elem_offset   = elem_offset;
+   cache->evict         = evict;
+   cache->priv          = priv;
+   cache->hits          = 0;
+   cache->misses        = 0;
+   cache->evictions     = 0;
+}
+
+/**
+ * deinitialize a LRU cache
+ * all the remaining objects are passed to evict callback
+ *
+ * @param cache LRU cache
+ */
+void
+deinitLRUCache(LRUCache* cache)
+{
+   while(!list_empty(&cache->lru))
+   {
+      evictElement(cache, getElementFromLRU(cache, cache->lru.prev));
+   }
+   deinitHash(&cache->hash);
+}
+
+/**
+ * get an object from LRU cache and make it the most recently used
+ *
+ * @param cache LRU cache
+ * @param key key to search with
+ * @return object found or NULL
+ */
+void*
+getLRUCache(LRUCache* cache, void* key)
+{
+   void* element;
+
+   element = lookupHash(&cache->hash, key);
+   if(element == NULL)
+   {
+      cache->misses++;
+      return NULL;
+   }
+
+   cache->hits++;
+   list_move(&getCacheElement(cache, element)->lru, &cache->lru);
+   return element;
+}
+
+/**
+ * put an object to LRU cache as the most recently used
+ * an object with the same key is replaced and passed to evict callback.
+ * putting an object already in cache just makes it the most recently used.
+ * the least recently used object is evicted when cache is full
+ *
+ * @param cache LRU cache
+ * @param element object to put
+ */
+void
+putLRUCache(LRUCache* cache, void* element)
+{
+   void* old;
+   int   count = cache->hash.numElements;
+
+   old = lookupOrAddHash(&cache->hash, element);
+   if(old == element && cache->hash.numElements == count)
+   {
+      // already cached. lru node is still linked
+      list_move(&getCacheElement(cache, element)->lru, &cache->lru);
+      return;
+   }
+
+   if(old != element)
+   {
+      evictElement(cache, old);
+      addHash(&cache->hash, element);
+   }
+   list_add(&getCacheElement(cache, element)->lru, &cache->lru);
+
+   while(cache->hash.numElements > cache->capacity)
+   {
+      cache->evictions++;
+      evictElement(cache, getElementFromLRU(cache, cache->lru.prev));
+   }
+}
+
+/**
+ * remove an object from LRU cache
+ * evict callback is not called
+ *
+ * @param cache LRU cache
+ * @param key key to search with
+ * @return object removed or NULL if not found
+ */
+void*
+removeLRUCache(LRUCache* cache, void* key)
+{
+   void* element;
+
+   element = removeHash(&cache->hash, key);
+   if(element != NULL)
+   {
+      list_del_init(&getCacheElement(cache, element)->lru);
+   }
+   return element;
+}
+
+/**
+ * print LRU cache statistics to fp
+ *
+ * @param cache LRU cache
+ * @param fp file pointer to write statistics to
+ */
+void
+printLRUCacheStat(LRUCache* cache, FILE* fp)
+{
+   unsigned long gets = cache->hits + cache->misses;
+
+   fprintf(fp, "=============== LRU CACHE STATISTICS ==============\n");
+   fprintf(fp, "SIZE %d, CAPACITY %d\n", cache->hash.numElements, cache->capacity);
+   fprintf(fp, "HITS %lu, MISSES %lu, HIT RATIO %.2f%%, EVICTIONS %lu\n",
+         cache->hits, cache->misses,
+         gets > 0 ? (double)cache->hits * 100 / gets : 0.0,
+         cache->evictions);
+   fflush(fp);
+}
@@ -0,0 +1,70 @@
+//
+// a bounded key to object cache with LRU eviction
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __LRU_CACHE_DEF_H__
+#define __LRU_CACHE_DEF_H__
+
+#include <stdio.h>
+#include "hash.h"
+
+/**
+ * a structure embedded in cached objects
+ */
+typedef struct lru_cache_element
+{
+   HashElement       he;               /** hash element for key lookup        */
+   struct list_head  lru;              /** recency list, most recent first    */
+} LRUCacheElement;
+
+struct lru_cache;
+
+/**
+ * called when an object leaves the cache by eviction or replacement.
+ * the object is no longer in the cache and belongs to the callback
+ */
+typedef void (*lru_evict_func)(struct lru_cache* cache, void* element, void* priv);
+
+/**
+ * LRU cache
+ *
+ * objects are found by key through a hash and ordered by recency in a list.
+ * a hit moves the object to the list head and eviction takes the list tail,
+ * so get, put and evict are all O(1)
+ */
+typedef struct lru_cache
+{
+   HashContext       hash;             /** key to object                      */
+   struct list_head  lru;              /** recency list                       */
+   int               capacity;         /** max number of objects              */
+   int               elem_offset;      /** offset of LRUCacheElement          */
+   lru_evict_func    evict;            /** eviction callback                  */
+   void*             priv;             /** private argument for callback      */
+   unsigned long     hits;             /** number of get hits                 */
+   unsigned long     misses;           /** number of get misses               */
+   unsigned long     evictions;        /** number of capacity evictions       */
+} LRUCache;
+
+extern void initLRUCache(LRUCache* cache, int capacity, int elem_offset,
+      int key_offset, int key_size, hash_func func, lru_evict_func evict, void* priv);
+extern void deinitLRUCache(LRUCache* cache);
+extern void* getLRUCache(LRUCache* cache, void* key);
+extern void putLRUCache(LRUCache* cache, void* element);
+extern void* removeLRUCache(LRUCache* cache, void* key);
+extern void printLRUCacheStat(LRUCache* cache, FILE* fp);
+
+/**
+ * number of objects in cache
+ */
+static inline int
+getLRUCacheSize(LRUCache* cache)
+{
+   return cache->hash.numElements;
+}
+
+#endif //!__LRU_CACHE_DEF_H__
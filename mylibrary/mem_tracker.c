@@ -9,10 +9,12 @@
 //
 #include <stdio.h>
 #include "hash.h"
+#include "obj_pool.h"
 #include <stdlib.h>
 #include <string.h>
 
 #define BUCKET_SIZE     1024
+#define INFO_PER_SLAB   256
 
 /**
  * a tag prepended to each memory allocated from heap
@@ -40,6 +42,11 @@ typedef struct
  */
 static HashContext memHash;
 
+/**
+ * pool for AllocInfo
+ */
+static ObjPool infoPool = OBJ_POOL_INIT(infoPool, sizeof(AllocInfo), INFO_PER_SLAB, 0);
+
 /**
  * initialize internal data structores for memory tracking
  */
@@ -50,6 +57,17 @@ initMemTracker(void)
          offsetof(AllocInfo, tag), sizeof(MemDebugTag) - sizeof(int), NULL);
 }
 
+static void
+printAllocInfo(HashContext* hash, void* element, void* priv)
+{
+   AllocInfo*  info = (AllocInfo*)element;
+   FILE*       fp   = (FILE*)priv;
+
+   fprintf(fp, "FILE %s, LINE %d, COUNT %d, TOTAL_SIZE %d\n",
+         info->tag.file, info->tag.line,
+         info->count, info->total_size);
+}
+
 /**
  * print memory tracking statistics to fp
  *
@@ -58,23 +76,9 @@ initMemTracker(void)
 void
 printMemStat(FILE* fp)
 {
-   int i;
-   struct list_head* pos;
-
    fprintf(fp, "=============== MEMORY TRACKING INFO ==============\n");
 
-   for(i = 0; i < BUCKET_SIZE; i++)
-   {
-      list_for_each(pos, &memHash.buckets[i])
-      {
-         AllocInfo* info;
-
-         info = (AllocInfo*)((char*)pos - memHash.offset);
-         fprintf(fp, "FILE %s, LINE %d, COUNT %d, TOTAL_SIZE %d\n",
-               info->tag.file, info->tag.line,
-               info->count, info->total_size);
-      }
-   }
+   iterateHash(&memHash, printAllocInfo, fp);
    fflush(fp);
 }
 
@@ -86,7 +90,7 @@ checkMalloc(MemDebugTag* tag)
    info = lookupHash(&memHash, tag);
    if(info == NULL)
    {
-      info = malloc(sizeof(AllocInfo));
+      info = alloc_obj(&infoPool);
       if(info == NULL)
       {
          return;
@@ -115,8 +119,8 @@ checkFree(MemDebugTag* tag)
       info->total_size -= tag->size;
       if(info->count == 0)
       {
-         delHash(&memHash, tag);
-         free(info);
+         delHashElement(&memHash, info);
+         free_obj(&infoPool, info);
       }
    }
 }
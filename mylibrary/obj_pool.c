@@ -0,0 +1,318 @@
+//
+// a fixed size object pool
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include <stdlib.h>
+#include "obj_pool.h"
+
+/**
+ * slab header placed in front of objects
+ * its size is rounded up to 16 bytes, so objects whose size is
+ * a multiple of 16 keep the 16 byte alignment malloc gives
+ */
+typedef struct
+{
+   struct list_head  next;             /** a list for slabs of a pool */
+} __attribute__((aligned(16))) ObjSlab;
+
+#define OBJ_NEXT(obj)      (*(void**)(obj))
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+static inline void
+lock_obj_pool(ObjPool* pool)
+{
+   if(pool->flags & OBJ_POOL_THREAD_SAFE)
+   {
+      pthread_mutex_lock(&pool->lock);
+   }
+}
+
+static inline void
+unlock_obj_pool(ObjPool* pool)
+{
+   if(pool->flags & OBJ_POOL_THREAD_SAFE)
+   {
+      pthread_mutex_unlock(&pool->lock);
+   }
+}
+
+//
+// adds a new slab. objects are chained in address order
+// so that objects allocated one after another sit next to each other
+//
+static int
+grow_obj_pool(ObjPool* pool)
+{
+   ObjSlab* slab;
+   char*    obj;
+   int      i;
+
+   slab = (ObjSlab*)malloc(sizeof(ObjSlab) + (size_t)pool->obj_size * pool->objs_per_slab);
+   if(slab == NULL)
+   {
+      return -1;
+   }
+
+   list_add_tail(&slab->next, &pool->slabs);
+   pool->num_slabs++;
+
+   obj = (char*)(slab + 1) + (size_t)pool->obj_size * (pool->objs_per_slab - 1);
+   for(i = 0; i < pool->objs_per_slab; i++)
+   {
+      OBJ_NEXT(obj)     = pool->free_list;
+      pool->free_list   = obj;
+      obj              -= pool->obj_size;
+   }
+   return 0;
+}
+
+static inline void*
+__alloc_obj(ObjPool* pool)
+{
+   void* obj;
+
+   if(pool->free_list == NULL && grow_obj_pool(pool) != 0)
+   {
+      return NULL;
+   }
+
+   obj               = pool->free_list;
+   pool->free_list   = OBJ_NEXT(obj);
+   pool->num_used++;
+   return obj;
+}
+
+static inline void
+__free_obj(ObjPool* pool, void* obj)
+{
+   OBJ_NEXT(obj)     = pool->free_list;
+   pool->free_list   = obj;
+   pool->num_used--;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * initialize an object pool
+ *
+ * @param pool object pool
+ * @param obj_size size of object
+ * @param objs_per_slab number of objects to allocate from heap at a time
+ * @param flags OBJ_POOL_THREAD_SAFE if the pool is shared by threads
+ * @return 0 on success, -1 on failure
+ */
+int
+init_obj_pool(ObjPool* pool, int obj_size, int objs_per_slab, int flags)
+{
+   if(obj_size <= 0 || objs_per_slab <= 0)
+   {
+      return -1;
+   }
+
+   pool->obj_size       = OBJ_POOL_ALIGN(obj_size);
+   pool->objs_per_slab  = objs_per_slab;
+   pool->flags          = flags;
+   pool->free_list      = NULL;
+   pool->num_slabs      = 0;
+   pool->num_used       = 0;
+
+   INIT_LIST_HEAD(&pool->slabs);
+
+   if(pthread_mutex_init(&pool->lock, NULL) != 0)
+   {
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * deinitialize an object pool
+ * all the objects from the pool become invalid
+ *
+ * @param pool object pool
+ */
+void
+deinit_obj_pool(ObjPool* pool)
+{
+   ObjSlab  *p, *n;
+
+   list_for_each_entry_safe(p, n, &pool->slabs, next)
+   {
+      list_del(&p->next);
+      free(p);
+   }
+
+   pool->free_list   = NULL;
+   pool->num_slabs   = 0;
+   pool->num_used    = 0;
+
+   pthread_mutex_destroy(&pool->lock);
+}
+
+/**
+ * allocate an object from pool
+ *
+ * @param pool object pool
+ * @return object or NULL on memory allocation failure
+ */
+void*
+alloc_obj(ObjPool* pool)
+{
+   void* obj;
+
+   lock_obj_pool(pool);
+   obj = __alloc_obj(pool);
+   unlock_obj_pool(pool);
+
+   return obj;
+}
+
+/**
+ * return an object to pool
+ *
+ * @param pool object pool the object is allocated from
+ * @param obj object to free
+ */
+void
+free_obj(ObjPool* pool, void* obj)
+{
+   if(obj == NULL)
+   {
+      return;
+   }
+
+   lock_obj_pool(pool);
+   __free_obj(pool, obj);
+   unlock_obj_pool(pool);
+}
+
+/**
+ * initialize a per thread object cache
+ *
+ * @param cache object cache
+ * @param pool object pool behind the cache
+ * @param batch number of objects moved between cache and pool at a time
+ */
+void
+init_obj_cache(ObjCache* cache, ObjPool* pool, int batch)
+{
+   cache->pool       = pool;
+   cache->free_list  = NULL;
+   cache->count      = 0;
+   cache->batch      = batch > 0 ? batch : 1;
+}
+
+/**
+ * deinitialize a per thread object cache
+ * cached objects go back to pool
+ *
+ * @param cache object cache
+ */
+void
+deinit_obj_cache(ObjCache* cache)
+{
+   void* obj;
+
+   lock_obj_pool(cache->pool);
+   while(cache->free_list != NULL)
+   {
+      obj               = cache->free_list;
+      cache->free_list  = OBJ_NEXT(obj);
+      __free_obj(cache->pool, obj);
+   }
+   unlock_obj_pool(cache->pool);
+
+   cache->count = 0;
+}
+
+/**
+ * allocate an object through per thread cache
+ * when the cache is empty, a batch of objects is taken from pool
+ *
+ * @param cache object cache
+ * @return object or NULL on memory allocation failure
+ */
+void*
+alloc_cached_obj(ObjCache* cache)
+{
+   void* obj;
+   int   i;
+
+   if(cache->free_list == NULL)
+   {
+      lock_obj_pool(cache->pool);
+      for(i = 0; i < cache->batch; i++)
+      {
+         obj = __alloc_obj(cache->pool);
+         if(obj == NULL)
+         {
+            break;
+         }
+
+         OBJ_NEXT(obj)     = cache->free_list;
+         cache->free_list  = obj;
+         cache->count++;
+      }
+      unlock_obj_pool(cache->pool);
+
+      if(cache->free_list == NULL)
+      {
+         return NULL;
+      }
+   }
+
+   obj               = cache->free_list;
+   cache->free_list  = OBJ_NEXT(obj);
+   cache->count--;
+   return obj;
+}
+
+/**
+ * free an object through per thread cache
+ * when the cache holds twice the batch, a batch of objects goes back to pool
+ *
+ * @param cache object cache
+ * @param obj object to free
+ */
+void
+free_cached_obj(ObjCache* cache, void* obj)
+{
+   int i;
+
+   if(obj == NULL)
+   {
+      return;
+   }
+
+   OBJ_NEXT(obj)     = cache->free_list;
+   cache->free_list  = obj;
+   cache->count++;
+
+   if(cache->count < cache->batch * 2)
+   {
+      return;
+   }
+
+   lock_obj_pool(cache->pool);
+   for(i = 0; i < cache->batch; i++)
+   {
+      obj               = cache->free_list;
+      cache->free_list  = OBJ_NEXT(obj);
+      cache->count--;
+
+      __free_obj(cache->pool, obj);
+   }
+   unlock_obj_pool(cache->pool);
+}
@@ -0,0 +1,75 @@
+//
+// a fixed size object pool
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __OBJ_POOL_DEF_H__
+#define __OBJ_POOL_DEF_H__
+
+#include <pthread.h>
+#include "list.h"
+
+#define OBJ_POOL_THREAD_SAFE     (1 << 0)    /** pool is shared by threads */
+
+#define OBJ_POOL_ALIGN(size)     \
+   (((size) < sizeof(void*) ? sizeof(void*) : (size) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+/**
+ * an object pool
+ * objects are carved out of slabs of objs_per_slab objects
+ * and recycled through a free list. slabs are returned only at deinit
+ */
+typedef struct obj_pool
+{
+   int               obj_size;         /** object size aligned to pointer size   */
+   int               objs_per_slab;    /** number of objects in a slab           */
+   int               flags;            /** OBJ_POOL_THREAD_SAFE                  */
+   void*             free_list;        /** free objects                          */
+   struct list_head  slabs;            /** allocated slabs                       */
+   int               num_slabs;        /** number of allocated slabs             */
+   int               num_used;         /** objects out of pool including caches  */
+   pthread_mutex_t   lock;             /** lock for OBJ_POOL_THREAD_SAFE         */
+} ObjPool;
+
+/**
+ * static initializer for an object pool
+ */
+#define OBJ_POOL_INIT(name, size, per_slab, pool_flags)  \
+{                                                        \
+   .obj_size         = OBJ_POOL_ALIGN(size),             \
+   .objs_per_slab    = (per_slab),                       \
+   .flags            = (pool_flags),                     \
+   .free_list        = NULL,                             \
+   .slabs            = LIST_HEAD_INIT((name).slabs),     \
+   .num_slabs        = 0,                                \
+   .num_used         = 0,                                \
+   .lock             = PTHREAD_MUTEX_INITIALIZER,        \
+}
+
+/**
+ * a per thread cache in front of a shared object pool
+ * objects move between cache and pool in batch
+ */
+typedef struct obj_cache
+{
+   ObjPool*          pool;             /** pool behind this cache                */
+   void*             free_list;        /** cached free objects                   */
+   int               count;            /** number of cached free objects         */
+   int               batch;            /** number of objects to move at a time   */
+} ObjCache;
+
+extern int init_obj_pool(ObjPool* pool, int obj_size, int objs_per_slab, int flags);
+extern void deinit_obj_pool(ObjPool* pool);
+extern void* alloc_obj(ObjPool* pool);
+extern void free_obj(ObjPool* pool, void* obj);
+
+extern void init_obj_cache(ObjCache* cache, ObjPool* pool, int batch);
+extern void deinit_obj_cache(ObjCache* cache);
+extern void* alloc_cached_obj(ObjCache* cache);
+extern void free_cached_obj(ObjCache* cache, void* obj);
+
+#endif //!__OBJ_POOL_DEF_H__
@@ -0,0 +1,445 @@
+//
+// a read mostly hash with lock free readers
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "rcu_hash.h"
+#include "hash_func.h"
+
+#define RCU_RETIRED_PER_SLAB     64
+
+/**
+ * a removed element waiting for readers to leave
+ */
+typedef struct
+{
+   struct list_head  next;             /** a list for retired elements        */
+   void*             element;          /** removed element                    */
+   unsigned long     epoch;            /** global epoch at removal            */
+} RCURetired;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+static inline HashElement*
+getHashElement(RCUHashContext* hash, void* element)
+{
+   return (HashElement*)((char*)element + hash->offset);
+}
+
+static inline void*
+getElement(RCUHashContext* hash, struct list_head* lh)
+{
+   return (char*)lh - hash->offset;
+}
+
+static inline void*
+getElementKey(RCUHashContext* hash, struct list_head* lh)
+{
+   return (char*)lh - hash->offset + hash->key_offset;
+}
+
+static struct list_head*
+findRCUHash(RCUHashContext* hash, void* key, unsigned int hv)
+{
+   struct list_head* pos;
+
+   list_for_each_rcu(pos, &hash->buckets[hv % hash->numBuckets])
+   {
+      if(list_entry(pos, HashElement, lh)->hash_value == hv &&
+         memcmp(key, getElementKey(hash, pos), hash->key_size) == 0)
+      {
+         return pos;
+      }
+   }
+   return NULL;
+}
+
+//
+// smallest epoch of readers in critical section, or ~0 if none
+//
+static unsigned long
+getMinReaderEpoch(RCUHashContext* hash)
+{
+   unsigned long  min = ~0ul,
+                  e;
+   int            i;
+
+   // pairs with the fence in rcuReadLock()
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   for(i = 0; i < RCU_HASH_MAX_READERS; i++)
+   {
+      e = __atomic_load_n(&hash->readers[i].epoch, __ATOMIC_ACQUIRE);
+      if(e != 0 && e < min)
+      {
+         min = e;
+      }
+   }
+   return min;
+}
+
+//
+// called with writer lock held after an element is unlinked.
+// every reader that entered before this point has epoch not greater
+// than the one returned, and every reader entering after sees the unlink
+//
+static void
+retireElement(RCUHashContext* hash, void* element)
+{
+   RCURetired*    r;
+   unsigned long  epoch;
+
+   epoch = __atomic_fetch_add(&hash->epoch, 1, __ATOMIC_SEQ_CST);
+
+   r = (RCURetired*)alloc_obj(&hash->retiredPool);
+   if(r == NULL)
+   {
+      // no memory to defer. wait for readers right here
+      while(getMinReaderEpoch(hash) <= epoch)
+      {
+         sched_yield();
+      }
+      hash->free_func(element, hash->priv);
+      return;
+   }
+
+   r->element  = element;
+   r->epoch    = epoch;
+   list_add_tail(&r->next, &hash->retired);
+}
+
+static void
+__reclaimRCUHash(RCUHashContext* hash)
+{
+   RCURetired     *r, *n;
+   unsigned long  min;
+
+   if(list_empty(&hash->retired))
+   {
+      return;
+   }
+
+   min = getMinReaderEpoch(hash);
+
+   // retired list is in epoch order
+   list_for_each_entry_safe(r, n, &hash->retired, next)
+   {
+      if(r->epoch >= min)
+      {
+         break;
+      }
+
+      list_del(&r->next);
+      hash->free_func(r->element, hash->priv);
+      free_obj(&hash->retiredPool, r);
+   }
+}
+
+static void
+insertRCUHash(RCUHashContext* hash, void* element, unsigned int hv)
+{
+   HashElement* he = getHashElement(hash, element);
+
+   he->hash_value = hv;
+   he->key_len    = hash->key_size;
+
+   list_add_tail_rcu(&he->lh, &hash->buckets[hv % hash->numBuckets]);
+   hash->numElements++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * initialize a RCU hash context
+ *
+ * @param hash RCU hash context
+ * @param numBuckets number of buckets, fixed for lifetime
+ * @param hash_offset offset of hash element
+ * @param key_offset offset of hash key
+ * @param key_size size of hash key to use
+ * @param func hash function to use, djb_hash if NULL
+ * @param free_func called to free elements removed from hash
+ * @param priv private argument for free_func
+ * @return 0 on success, -1 on failure
+ */
+int
+initRCUHash(RCUHashContext* hash, int numBuckets, int hash_offset,
+      int key_offset, int key_size, hash_func func, rcu_free_func free_func, void* priv)
+{
+   void* readers;
+   int   i;
+
+   if(posix_memalign(&readers, RCU_HASH_CACHE_LINE, sizeof(RCUReader) * RCU_HASH_MAX_READERS) != 0)
+   {
+      return -1;
+   }
+
+   hash->buckets = (struct list_head*)malloc(sizeof(struct list_head) * numBuckets);
+   if(hash->buckets == NULL)
+   {
+      free(readers);
+      return -1;
+   }
+
+   for(i = 0; i < numBuckets; i++)
+   {
+      INIT_LIST_HEAD(&hash->buckets[i]);
+   }
+
+   memset(readers, 0, sizeof(RCUReader) * RCU_HASH_MAX_READERS);
+
+   hash->numBuckets     = numBuckets;
+   hash->offset         = hash_offset;
+   hash->key_offset     = key_offset;
+   hash->key_size       = key_size;
+   hash->calc_hash      = func != NULL ? func : djb_hash;
+   hash->numElements    = 0;
+   hash->free_func      = free_func;
+   hash->priv           = priv;
+   hash->readers        = (RCUReader*)readers;
+   hash->epoch          = 1;
+
+   INIT_LIST_HEAD(&hash->retired);
+   pthread_mutex_init(&hash->lock, NULL);
+   init_obj_pool(&hash->retiredPool, sizeof(RCURetired), RCU_RETIRED_PER_SLAB, 0);
+   return 0;
+}
+
+/**
+ * deinitialize a RCU hash context
+ * no reader or writer should be accessing the hash.
+ * retired elements and all the elements left in hash are passed to free_func
+ *
+ * @param hash RCU hash context
+ */
+void
+deinitRCUHash(RCUHashContext* hash)
+{
+   struct list_head  *pos, *n;
+   int               i;
+
+   __reclaimRCUHash(hash);
+
+   for(i = 0; i < hash->numBuckets; i++)
+   {
+      list_for_each_safe(pos, n, &hash->buckets[i])
+      {
+         hash->free_func(getElement(hash, pos), hash->priv);
+      }
+   }
+
+   deinit_obj_pool(&hash->retiredPool);
+   pthread_mutex_destroy(&hash->lock);
+   free(hash->buckets);
+   free(hash->readers);
+   hash->buckets = NULL;
+   hash->readers = NULL;
+}
+
+/**
+ * register a reader thread
+ * each thread reading the hash needs its own reader slot
+ *
+ * @param hash RCU hash context
+ * @return reader slot or NULL if all slots are taken
+ */
+RCUReader*
+registerRCUReader(RCUHashContext* hash)
+{
+   int i, expected;
+
+   for(i = 0; i < RCU_HASH_MAX_READERS; i++)
+   {
+      expected = 0;
+      if(__atomic_compare_exchange_n(&hash->readers[i].used, &expected, 1, 0,
+               __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      {
+         return &hash->readers[i];
+      }
+   }
+   return NULL;
+}
+
+/**
+ * unregister a reader thread
+ *
+ * @param hash RCU hash context
+ * @param reader reader slot returned by registerRCUReader(), not in critical section
+ */
+void
+unregisterRCUReader(RCUHashContext* hash, RCUReader* reader)
+{
+   __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+   __atomic_store_n(&reader->used, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * lookup RCU hash for a given key
+ * must be called between rcuReadLock() and rcuReadUnlock()
+ *
+ * @param hash RCU hash context
+ * @param key key to search with
+ * @return element found, valid until rcuReadUnlock(), or NULL
+ */
+void*
+lookupRCUHash(RCUHashContext* hash, void* key)
+{
+   struct list_head* pos;
+
+   pos = findRCUHash(hash, key, hash->calc_hash(key, hash->key_size));
+   if(pos == NULL)
+   {
+      return NULL;
+   }
+   return getElement(hash, pos);
+}
+
+/**
+ * add a new element to RCU hash
+ *
+ * @param hash RCU hash context
+ * @param element element to add
+ * @return 0 on failure, 1 on success
+ */
+int
+addRCUHash(RCUHashContext* hash, void* element)
+{
+   void*          key = (char*)element + hash->key_offset;
+   unsigned int   hv = hash->calc_hash(key, hash->key_size);
+   int            ret = 0;
+
+   pthread_mutex_lock(&hash->lock);
+   if(findRCUHash(hash, key, hv) == NULL)
+   {
+      insertRCUHash(hash, element, hv);
+      ret = 1;
+   }
+   pthread_mutex_unlock(&hash->lock);
+
+   return ret;
+}
+
+/**
+ * add an element to RCU hash replacing the one with the same key
+ * readers see either old or new element, never none.
+ * old element is passed to free_func after readers are done with it
+ *
+ * @param hash RCU hash context
+ * @param element element to add
+ * @return 1 if an element is replaced, 0 if added
+ */
+int
+replaceRCUHash(RCUHashContext* hash, void* element)
+{
+   void*             key = (char*)element + hash->key_offset;
+   unsigned int      hv = hash->calc_hash(key, hash->key_size);
+   struct list_head* old;
+   HashElement*      he = getHashElement(hash, element);
+
+   pthread_mutex_lock(&hash->lock);
+
+   old = findRCUHash(hash, key, hv);
+   if(old == NULL)
+   {
+      insertRCUHash(hash, element, hv);
+      pthread_mutex_unlock(&hash->lock);
+      return 0;
+   }
+
+   he->hash_value = hv;
+   he->key_len    = hash->key_size;
+   list_replace_rcu(old, &he->lh);
+
+   retireElement(hash, getElement(hash, old));
+   __reclaimRCUHash(hash);
+
+   pthread_mutex_unlock(&hash->lock);
+   return 1;
+}
+
+/**
+ * delete an element with given key from RCU hash
+ * the element is passed to free_func after readers are done with it
+ *
+ * @param hash RCU hash context
+ * @param key key to search with
+ * @return 1 on success, 0 if not found
+ */
+int
+delRCUHash(RCUHashContext* hash, void* key)
+{
+   unsigned int      hv = hash->calc_hash(key, hash->key_size);
+   struct list_head* pos;
+
+   pthread_mutex_lock(&hash->lock);
+
+   pos = findRCUHash(hash, key, hv);
+   if(pos == NULL)
+   {
+      pthread_mutex_unlock(&hash->lock);
+      return 0;
+   }
+
+   list_del_rcu(pos);
+   hash->numElements--;
+
+   retireElement(hash, getElement(hash, pos));
+   __reclaimRCUHash(hash);
+
+   pthread_mutex_unlock(&hash->lock);
+   return 1;
+}
+
+/**
+ * free retired elements no reader can see any more
+ * writers do this on every update. call it when updates are rare
+ * and retired elements should not be kept for long
+ *
+ * @param hash RCU hash context
+ */
+void
+reclaimRCUHash(RCUHashContext* hash)
+{
+   pthread_mutex_lock(&hash->lock);
+   __reclaimRCUHash(hash);
+   pthread_mutex_unlock(&hash->lock);
+}
+
+/**
+ * wait until all the retired elements are freed
+ * must not be called in read side critical section
+ *
+ * @param hash RCU hash context
+ */
+void
+synchronizeRCUHash(RCUHashContext* hash)
+{
+   int done;
+
+   while(1)
+   {
+      pthread_mutex_lock(&hash->lock);
+      __reclaimRCUHash(hash);
+      done = list_empty(&hash->retired);
+      pthread_mutex_unlock(&hash->lock);
+
+      if(done)
+      {
+         break;
+      }
+      sched_yield();
+   }
+}
@@ -0,0 +1,107 @@
+//
+// a read mostly hash with lock free readers
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __RCU_HASH_DEF_H__
+#define __RCU_HASH_DEF_H__
+
+#include <pthread.h>
+#include "hash.h"
+#include "obj_pool.h"
+
+#define RCU_HASH_MAX_READERS     128
+#define RCU_HASH_CACHE_LINE      64
+
+/**
+ * a reader thread of RCU hash
+ * epoch is 0 outside of read side critical section
+ */
+typedef struct rcu_reader
+{
+   unsigned long     epoch;            /** epoch observed at rcuReadLock()    */
+   int               used;             /** slot is registered                 */
+} __attribute__((aligned(RCU_HASH_CACHE_LINE))) RCUReader;
+
+/**
+ * called when a removed element can be freed
+ */
+typedef void (*rcu_free_func)(void* element, void* priv);
+
+/**
+ * a RCU hash context
+ *
+ * readers walk bucket chains with plain loads between rcuReadLock() and
+ * rcuReadUnlock(), never taking a lock or doing an atomic read-modify-write.
+ * writers are serialized by a mutex, publish changes with release stores
+ * and retire removed elements with the global epoch at removal.
+ * a retired element is freed once every reader in critical section
+ * has entered after its removal.
+ *
+ * number of buckets is fixed at initialization.
+ */
+typedef struct rcu_hash_context
+{
+   int               numBuckets;       /** number of buckets                  */
+   int               offset;           /** offset of hash element             */
+   int               key_offset;       /** hash key offset                    */
+   int               key_size;         /** hash key size                      */
+   hash_func         calc_hash;        /** hash function to use               */
+   struct list_head* buckets;          /** bucket list                        */
+   int               numElements;      /** number of elements in hash         */
+   rcu_free_func     free_func;        /** frees removed elements             */
+   void*             priv;             /** private argument for free_func     */
+   pthread_mutex_t   lock;             /** serializes writers                 */
+   struct list_head  retired;          /** removed elements waiting for readers */
+   ObjPool           retiredPool;      /** pool for retired element records   */
+   RCUReader*        readers;          /** reader slots                       */
+   unsigned long     epoch             /** global epoch, starts from 1        */
+                     __attribute__((aligned(RCU_HASH_CACHE_LINE)));
+} RCUHashContext;
+
+extern int initRCUHash(RCUHashContext* hash, int numBuckets, int hash_offset,
+      int key_offset, int key_size, hash_func func, rcu_free_func free_func, void* priv);
+extern void deinitRCUHash(RCUHashContext* hash);
+
+extern RCUReader* registerRCUReader(RCUHashContext* hash);
+extern void unregisterRCUReader(RCUHashContext* hash, RCUReader* reader);
+
+extern void* lookupRCUHash(RCUHashContext* hash, void* key);
+extern int addRCUHash(RCUHashContext* hash, void* element);
+extern int replaceRCUHash(RCUHashContext* hash, void* element);
+extern int delRCUHash(RCUHashContext* hash, void* key);
+extern void reclaimRCUHash(RCUHashContext* hash);
+extern void synchronizeRCUHash(RCUHashContext* hash);
+
+/**
+ * enter read side critical section
+ * elements looked up are valid until rcuReadUnlock(). no nesting
+ *
+ * @param hash RCU hash context
+ * @param reader reader slot of calling thread
+ */
+static inline void
+rcuReadLock(RCUHashContext* hash, RCUReader* reader)
+{
+   __atomic_store_n(&reader->epoch, __atomic_load_n(&hash->epoch, __ATOMIC_RELAXED),
+         __ATOMIC_RELAXED);
+   // epoch must be visible to writers before any chain is read
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * leave read side critical section
+ *
+ * @param reader reader slot of calling thread
+ */
+static inline void
+rcuReadUnlock(RCUReader* reader)
+{
+   __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+#endif //!__RCU_HASH_DEF_H__
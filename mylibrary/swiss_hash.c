@@ -0,0 +1,437 @@
+//
+// an open addressing hash with grouped control bytes
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#include "swiss_hash.h"
+#include "hash_func.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//
+// control byte values
+// a full slot has 7 bit hash in it, so only empty and deleted have the sign bit
+//
+#define CTRL_EMPTY            ((signed char)0x80)
+#define CTRL_DELETED          ((signed char)0xfe)
+
+#define SWISS_HASH_MIN_SLOTS  SWISS_HASH_GROUP_SIZE
+
+//
+// a table is filled up to 7/8 before it grows
+//
+#define SWISS_HASH_MAX_LOAD(n)   ((n) - (n) / 8)
+
+#define H1(hv)                ((hv) >> 7)
+#define H2(hv)                ((signed char)((hv) & 0x7f))
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// both H1 and H2 come out of a single hash value.
+// mix it so that weak hash functions still spread over low 7 bits
+//
+static inline unsigned int
+mix_hash(unsigned int h)
+{
+   h ^= h >> 16;
+   h *= 0x85ebca6b;
+   h ^= h >> 13;
+   h *= 0xc2b2ae35;
+   h ^= h >> 16;
+   return h;
+}
+
+static inline unsigned int
+calcSwissHash(SwissHashContext* hash, void* key)
+{
+   return mix_hash(hash->calc_hash((unsigned char*)key, hash->key_size));
+}
+
+static inline void*
+getElementKey(SwissHashContext* hash, void* element)
+{
+   return (char*)element + hash->key_offset;
+}
+
+//
+// group match returns a bit mask. bit i is set when ctrl[pos + i] matches
+//
+#ifdef __SSE2__
+static inline unsigned int
+matchByte(signed char* ctrl, signed char b)
+{
+   __m128i  g = _mm_loadu_si128((__m128i*)ctrl);
+
+   return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(b)));
+}
+
+static inline unsigned int
+matchEmptyOrDeleted(signed char* ctrl)
+{
+   return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((__m128i*)ctrl));
+}
+#else
+static inline unsigned int
+matchByte(signed char* ctrl, signed char b)
+{
+   unsigned int m = 0;
+   int i;
+
+   for(i = 0; i < SWISS_HASH_GROUP_SIZE; i++)
+   {
+      if(ctrl[i] == b)
+      {
+         m |= 1 << i;
+      }
+   }
+   return m;
+}
+
+static inline unsigned int
+matchEmptyOrDeleted(signed char* ctrl)
+{
+   unsigned int m = 0;
+   int i;
+
+   for(i = 0; i < SWISS_HASH_GROUP_SIZE; i++)
+   {
+      if(ctrl[i] < 0)
+      {
+         m |= 1 << i;
+      }
+   }
+   return m;
+}
+#endif
+
+static inline unsigned int
+matchEmpty(signed char* ctrl)
+{
+   return matchByte(ctrl, CTRL_EMPTY);
+}
+
+//
+// the first group - 1 control bytes are cloned after the last slot
+// so that a group load starting anywhere never wraps
+//
+static inline void
+setCtrl(SwissHashContext* hash, int i, signed char c)
+{
+   int mask = hash->numSlots - 1;
+
+   hash->ctrl[i] = c;
+   hash->ctrl[((i - (SWISS_HASH_GROUP_SIZE - 1)) & mask) + (SWISS_HASH_GROUP_SIZE - 1)] = c;
+}
+
+//
+// probe sequence visits groups at triangular offsets,
+// which covers every group when the number of slots is a power of 2
+//
+static int
+findSlot(SwissHashContext* hash, void* key, unsigned int hv)
+{
+   int            mask = hash->numSlots - 1,
+                  pos = H1(hv) & mask,
+                  stride = 0;
+   unsigned int   m;
+   signed char*   g;
+
+   while(1)
+   {
+      g = &hash->ctrl[pos];
+
+      for(m = matchByte(g, H2(hv)); m != 0; m &= m - 1)
+      {
+         int i = (pos + __builtin_ctz(m)) & mask;
+
+         if(memcmp(key, getElementKey(hash, hash->slots[i]), hash->key_size) == 0)
+         {
+            return i;
+         }
+      }
+
+      if(matchEmpty(g) != 0)
+      {
+         return -1;
+      }
+
+      stride += SWISS_HASH_GROUP_SIZE;
+      pos = (pos + stride) & mask;
+   }
+}
+
+static int
+findInsertSlot(SwissHashContext* hash, unsigned int hv)
+{
+   int            mask = hash->numSlots - 1,
+                  pos = H1(hv) & mask,
+                  stride = 0;
+   unsigned int   m;
+
+   while(1)
+   {
+      m = matchEmptyOrDeleted(&hash->ctrl[pos]);
+      if(m != 0)
+      {
+         return (pos + __builtin_ctz(m)) & mask;
+      }
+
+      stride += SWISS_HASH_GROUP_SIZE;
+      pos = (pos + stride) & mask;
+   }
+}
+
+static int
+allocSlots(SwissHashContext* hash, int numSlots)
+{
+   hash->ctrl = (signed char*)malloc(numSlots + SWISS_HASH_GROUP_SIZE);
+   if(hash->ctrl == NULL)
+   {
+      return -1;
+   }
+
+   hash->slots = (void**)malloc(sizeof(void*) * numSlots);
+   if(hash->slots == NULL)
+   {
+      free(hash->ctrl);
+      hash->ctrl = NULL;
+      return -1;
+   }
+
+   memset(hash->ctrl, CTRL_EMPTY, numSlots + SWISS_HASH_GROUP_SIZE);
+   hash->numSlots    = numSlots;
+   hash->growthLeft  = SWISS_HASH_MAX_LOAD(numSlots);
+   return 0;
+}
+
+//
+// moves every element to a new slot array.
+// the table doubles unless most of used slots are tombstones,
+// in which case it is rebuilt in the same size
+//
+static int
+resizeSwissHash(SwissHashContext* hash)
+{
+   signed char*   oldCtrl = hash->ctrl;
+   void**         oldSlots = hash->slots;
+   int            oldNumSlots = hash->numSlots,
+                  numSlots = oldNumSlots,
+                  i, ndx;
+   unsigned int   hv;
+
+   if(hash->numElements >= SWISS_HASH_MAX_LOAD(oldNumSlots) / 2)
+   {
+      numSlots *= 2;
+   }
+
+   if(allocSlots(hash, numSlots) != 0)
+   {
+      hash->ctrl        = oldCtrl;
+      hash->slots       = oldSlots;
+      return -1;
+   }
+
+   for(i = 0; i < oldNumSlots; i++)
+   {
+      if(oldCtrl[i] < 0)
+      {
+         continue;
+      }
+
+      hv  = calcSwissHash(hash, getElementKey(hash, oldSlots[i]));
+      ndx = findInsertSlot(hash, hv);
+      setCtrl(hash, ndx, H2(hv));
+      hash->slots[ndx] = oldSlots[i];
+   }
+   hash->growthLeft -= hash->numElements;
+
+   free(oldCtrl);
+   free(oldSlots);
+   return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// public utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * initialize a swiss hash context
+ *
+ * @param hash swiss hash context block
+ * @param numSlots initial number of slots. rounded up to power of 2
+ * @param key_offset offset of hash key
+ * @param key_size size of hash key to use
+ * @param func hash function to use, wy_hash if NULL
+ * @return 0 on success, -1 on memory allocation failure
+ */
+int
+initSwissHash(SwissHashContext* hash, int numSlots,
+      int key_offset, int key_size, hash_func func)
+{
+   int n = SWISS_HASH_MIN_SLOTS;
+
+   while(n < numSlots)
+   {
+      n *= 2;
+   }
+
+   hash->key_offset     = key_offset;
+   hash->key_size       = key_size;
+   hash->calc_hash      = func != NULL ? func : wy_hash;
+   hash->numElements    = 0;
+
+   return allocSlots(hash, n);
+}
+
+/**
+ * deinitialize swiss hash context block
+ */
+void
+deinitSwissHash(SwissHashContext* hash)
+{
+   free(hash->ctrl);
+   free(hash->slots);
+   hash->ctrl  = NULL;
+   hash->slots = NULL;
+}
+
+/**
+ * lookup swiss hash for a given key
+ *
+ * @param hash swiss hash context block
+ * @param key key to search with
+ * @return NULL when key is not found, pointer to client structure when found
+ */
+void*
+lookupSwissHash(SwissHashContext* hash, void* key)
+{
+   int ndx;
+
+   ndx = findSlot(hash, key, calcSwissHash(hash, key));
+   if(ndx < 0)
+   {
+      return NULL;
+   }
+   return hash->slots[ndx];
+}
+
+/**
+ * add a new client element to swiss hash
+ *
+ * @param hash swiss hash context block
+ * @param element hash client element
+ * @return 0 on failure, 1 on success
+ */
+int
+addSwissHash(SwissHashContext* hash, void* element)
+{
+   void*          key = getElementKey(hash, element);
+   unsigned int   hv = calcSwissHash(hash, key);
+   int            ndx;
+
+   if(findSlot(hash, key, hv) >= 0)
+   {
+      return 0;
+   }
+
+   ndx = findInsertSlot(hash, hv);
+
+   // reusing a tombstone doesn't eat up growth
+   if(hash->growthLeft == 0 && hash->ctrl[ndx] == CTRL_EMPTY)
+   {
+      if(resizeSwissHash(hash) != 0)
+      {
+         return 0;
+      }
+      ndx = findInsertSlot(hash, hv);
+   }
+
+   if(hash->ctrl[ndx] == CTRL_EMPTY)
+   {
+      hash->growthLeft--;
+   }
+
+   setCtrl(hash, ndx, H2(hv));
+   hash->slots[ndx] = element;
+   hash->numElements++;
+   return 1;
+}
+
+/**
+ * delete a hash client element with given key from swiss hash context
+ *
+ * @param hash swiss hash context block
+ * @param key hash key to search with
+ * @return 1 on success, 0 on failure
+ */
+int
+delSwissHash(SwissHashContext* hash, void* key)
+{
+   int            ndx,
+                  mask = hash->numSlots - 1;
+   unsigned int   before,
+                  after;
+
+   ndx = findSlot(hash, key, calcSwissHash(hash, key));
+   if(ndx < 0)
+   {
+      return 0;
+   }
+
+   //
+   // a slot can go back to empty only if no probe sequence
+   // ever saw a full group across it. otherwise leave a tombstone
+   //
+   before = matchEmpty(&hash->ctrl[(ndx - SWISS_HASH_GROUP_SIZE) & mask]);
+   after  = matchEmpty(&hash->ctrl[ndx]);
+
+   if(before != 0 && after != 0 &&
+      __builtin_ctz(after) + (__builtin_clz(before) - (32 - SWISS_HASH_GROUP_SIZE)) <
+      SWISS_HASH_GROUP_SIZE)
+   {
+      setCtrl(hash, ndx, CTRL_EMPTY);
+      hash->growthLeft++;
+   }
+   else
+   {
+      setCtrl(hash, ndx, CTRL_DELETED);
+   }
+
+   hash->numElements--;
+   return 1;
+}
+
+/**
+ * iterate over all the elements in swiss hash
+ * the iterator must not add or delete elements
+ *
+ * @param hash swiss hash context block
+ * @param it iteration callback
+ * @param priv private argument for iteration callback
+ */
+void
+iterateSwissHash(SwissHashContext* hash, swiss_hash_iterator it, void* priv)
+{
+   int i;
+
+   for(i = 0; i < hash->numSlots; i++)
+   {
+      if(hash->ctrl[i] >= 0)
+      {
+         it(hash, hash->slots[i], priv);
+      }
+   }
+}
@@ -0,0 +1,53 @@
+//
+// an open addressing hash with grouped control bytes
+//
+// all rights reserved, agent, 2026
+//
+// Revision History
+// - Oct/17/2026, initial release by agent
+//
+//
+#ifndef __SWISS_HASH_DEF_H__
+#define __SWISS_HASH_DEF_H__
+
+#include "hash.h"
+
+/**
+ * slots are probed a group at a time
+ */
+#define SWISS_HASH_GROUP_SIZE    16
+
+/**
+ * an open addressing hash context
+ *
+ * each slot has a control byte holding 7 bits of the hash value
+ * or an empty/deleted marker. a lookup compares a group of 16 control bytes
+ * at once and touches an element only when its control byte matches.
+ * elements are not intrusive. the table keeps pointers to client elements
+ */
+typedef struct swiss_hash_context
+{
+   int               numSlots;         /** number of slots, power of 2        */
+   int               key_offset;       /** hash key offset                    */
+   int               key_size;         /** hash key size                      */
+   hash_func         calc_hash;        /** hash function to use               */
+   signed char*      ctrl;             /** control bytes, numSlots + group    */
+   void**            slots;            /** client elements                    */
+   int               numElements;      /** number of elements in hash         */
+   int               growthLeft;       /** empty slots usable before resize   */
+} SwissHashContext;
+
+/**
+ * swiss hash iteration callback
+ */
+typedef void (*swiss_hash_iterator)(SwissHashContext* hash, void* element, void* priv);
+
+extern int initSwissHash(SwissHashContext* hash, int numSlots,
+      int key_offset, int key_size, hash_func func);
+extern void deinitSwissHash(SwissHashContext* hash);
+extern int addSwissHash(SwissHashContext* hash, void* element);
+extern void* lookupSwissHash(SwissHashContext* hash, void* key);
+extern int delSwissHash(SwissHashContext* hash, void* key);
+extern void iterateSwissHash(SwissHashContext* hash, swiss_hash_iterator it, void* priv);
+
+#endif //!__SWISS_HASH_DEF_H__
@@ -9,9 +9,485 @@
 //
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
 #include "timer.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define TIMER_HAVE_TSC
+#endif
+
+//
+// hierarchical wheel layout
+// level 0 has 256 buckets of one tick each and level 1 ~ 4 have 64 buckets
+// each covering 64 times the range of a bucket in the level below.
+// 5 levels cover the whole 32 bit tick range
+//
+#define TIMER_WHEEL_L0_BITS      8
+#define TIMER_WHEEL_LN_BITS      6
+#define TIMER_WHEEL_L0_SIZE      (1 << TIMER_WHEEL_L0_BITS)
+#define TIMER_WHEEL_LN_SIZE      (1 << TIMER_WHEEL_LN_BITS)
+#define TIMER_WHEEL_L0_MASK      (TIMER_WHEEL_L0_SIZE - 1)
+#define TIMER_WHEEL_LN_MASK      (TIMER_WHEEL_LN_SIZE - 1)
+#define TIMER_WHEEL_LEVELS       5
+#define TIMER_WHEEL_BUCKETS      (TIMER_WHEEL_L0_SIZE + (TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LN_SIZE)
+
+#define TIMER_WHEEL_SHIFT(level) (TIMER_WHEEL_L0_BITS + ((level) - 1) * TIMER_WHEEL_LN_BITS)
+#define TIMER_WHEEL_INDEX(level, slot)  \
+   (TIMER_WHEEL_L0_SIZE + ((level) - 1) * TIMER_WHEEL_LN_SIZE + (slot))
+
+//
+// elapsed time longer than this many ticks is taken as a wall clock jump
+// with TIMER_CLOCK_REALTIME
+//
+#define TIMER_JUMP_TICKS         3
+
+//
+// earliest tick in a bucket of TIMER_MODE_WHEEL.
+// a bucket holds timers of many rounds, so finding the next expiry
+// would otherwise walk every running timer. the minimum is lowered on add
+// and recomputed only when the element holding it is gone
+//
+typedef struct _timer_bucket_min
+{
+   unsigned int   tick;          /** earliest tick in the bucket           */
+   int            valid;         /** 0 when tick has to be recomputed      */
+} TimerBucketMin;
+
+#ifdef TIMER_HAVE_TSC
+#define TIMER_TSC_CALIBRATE_NSEC 10000000
+
+static struct
+{
+   unsigned long long   tsc;           /** TSC at calibration                 */
+   unsigned long long   nsec;          /** CLOCK_MONOTONIC at calibration     */
+   unsigned long long   mult;          /** nanoseconds per TSC cycle, 32.32   */
+   int                  valid;
+} tscClock;
+
+static pthread_once_t   tscOnce = PTHREAD_ONCE_INIT;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// static utilities
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static inline unsigned long long
+get_clock_nsec(clockid_t id)
+{
+   struct timespec ts;
+
+   clock_gettime(id, &ts);
+   return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#ifdef TIMER_HAVE_TSC
+//
+// TSC is converted to nanoseconds with a 32.32 fixed point multiplier
+// measured against CLOCK_MONOTONIC, and offset to CLOCK_MONOTONIC base.
+// only used when TSC is invariant, i.e. runs at constant rate in all states
+//
+static void
+calibrate_tsc(void)
+{
+   unsigned int         eax, ebx, ecx, edx;
+   unsigned long long   t0, t1, c0, c1;
+   struct timespec      ts = { 0, TIMER_TSC_CALIBRATE_NSEC };
+
+   if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8)))
+   {
+      return;
+   }
+
+   t0 = get_clock_nsec(CLOCK_MONOTONIC);
+   c0 = __rdtsc();
+   nanosleep(&ts, NULL);
+   t1 = get_clock_nsec(CLOCK_MONOTONIC);
+   c1 = __rdtsc();
+
+   if(c1 <= c0 || t1 <= t0)
+   {
+      return;
+   }
+
+   tscClock.mult  = ((t1 - t0) << 32) / (c1 - c0);
+   tscClock.tsc   = c1;
+   tscClock.nsec  = t1;
+   tscClock.valid = 1;
+}
+
+static inline unsigned long long
+get_tsc_nsec(void)
+{
+   return tscClock.nsec +
+      (unsigned long long)(((unsigned __int128)(__rdtsc() - tscClock.tsc) * tscClock.mult) >> 32);
+}
+#endif
+
+static inline unsigned long long
+read_timer_clock(Timer* timer)
+{
+   struct timeval tv;
+
+   switch(timer->clock)
+   {
+   case TIMER_CLOCK_MONOTONIC_COARSE:
+      return get_clock_nsec(CLOCK_MONOTONIC_COARSE);
+
+#ifdef TIMER_HAVE_TSC
+   case TIMER_CLOCK_TSC:
+      return get_tsc_nsec();
+#endif
+
+   case TIMER_CLOCK_REALTIME:
+      gettimeofday(&tv, NULL);
+      return tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+
+   default:
+      return get_clock_nsec(CLOCK_MONOTONIC);
+   }
+}
+
+//
+// elements with the same deadline go to the right,
+// so they expire in the order they were added
+//
+static void
+insert_ordered_timer(Timer* timer, TimerElem* elem)
+{
+   struct rb_node**  p = &timer->root.rb_node;
+   struct rb_node*   parent = NULL;
+   int               leftmost = 1;
+
+   while(*p)
+   {
+      parent = *p;
+      if(elem->deadline < rb_entry(parent, TimerElem, node)->deadline)
+      {
+         p = &parent->rb_left;
+      }
+      else
+      {
+         p = &parent->rb_right;
+         leftmost = 0;
+      }
+   }
+
+   if(leftmost)
+   {
+      timer->first = &elem->node;
+   }
+
+   rb_link_node(&elem->node, parent, p);
+   rb_insert_color(&elem->node, &timer->root);
+}
+
+static void
+erase_ordered_timer(Timer* timer, TimerElem* elem)
+{
+   if(timer->first == &elem->node)
+   {
+      timer->first = rb_next(&elem->node);
+   }
+   rb_erase(&elem->node, &timer->root);
+   RB_CLEAR_NODE(&elem->node);
+}
+
+static void
+run_expired_timer(struct list_head* timeout_list)
+{
+   TimerElem* p;
+
+   while(!list_empty(timeout_list))
+   {
+      p = list_first_entry(timeout_list, TimerElem, next);
+      list_del_init(&p->next);
+      p->cb(p);
+   }
+}
+
+//
+// expired elements are moved to a timeout list first, so that a callback
+// re-adding its timer with zero timeout doesn't run again in the same call
+//
+static void
+drive_ordered_timer(Timer* timer)
+{
+   unsigned long long   now = read_timer_clock(timer);
+   TimerElem*           p;
+   struct list_head     timeout_list = LIST_HEAD_INIT(timeout_list);
+
+   while(timer->first != NULL)
+   {
+      p = rb_entry(timer->first, TimerElem, node);
+      if(p->deadline > now)
+      {
+         break;
+      }
+
+      erase_ordered_timer(timer, p);
+      list_add_tail(&p->next, &timeout_list);
+      timer->num_running--;
+   }
+
+   run_expired_timer(&timeout_list);
+}
+
+//
+// time passed since the previous drive_timer() call
+//
+static inline long long
+get_elapsed_nsec(Timer* timer, unsigned long long now)
+{
+   long long elapsed = (long long)(now - timer->prev);
+
+   // defensive guard against sudden wall clock change
+   if(timer->clock == TIMER_CLOCK_REALTIME &&
+      (elapsed < 0 || elapsed >= TIMER_JUMP_TICKS * timer->tick_nsec))
+   {
+      elapsed = elapsed < 0 ? 0 : timer->tick_nsec;
+   }
+   return elapsed;
+}
+
+//
+// a wheel handles tick of timer->tick + d
+// when accumulated time reaches (d + 1) tick rates.
+// time since the previous drive_timer() call is counted from now,
+// so the deadline is right however long ago the wheel was driven
+//
+static inline unsigned long long
+get_tick_deadline(Timer* timer, unsigned int tick, unsigned long long now)
+{
+   return now + (long long)(tick - timer->tick + 1) * timer->tick_nsec -
+      timer->accumulated - get_elapsed_nsec(timer, now);
+}
+
+//
+// timerfd is armed with relative time, so deadlines
+// can come from any clock the timer is driven with
+//
+static void
+arm_timer_fd(Timer* timer, unsigned long long deadline, unsigned long long now)
+{
+   struct itimerspec its;
+
+   memset(&its, 0, sizeof(its));
+   if(deadline != 0)
+   {
+      // zero disarms timerfd, so an overdue deadline fires in a nanosecond
+      deadline = deadline > now ? deadline - now : 1;
+      its.it_value.tv_sec  = deadline / 1000000000ULL;
+      its.it_value.tv_nsec = deadline % 1000000000ULL;
+   }
+
+   timerfd_settime(timer->fd, 0, &its, NULL);
+}
+
+static inline void
+update_timer_fd(Timer* timer, unsigned long long deadline, unsigned long long now)
+{
+   if(timer->fd_deadline == 0 || deadline < timer->fd_deadline)
+   {
+      timer->fd_deadline = deadline;
+      arm_timer_fd(timer, deadline, now);
+   }
+}
+
+static void
+rearm_timer_fd(Timer* timer)
+{
+   unsigned long long   now,
+                        deadline = 0;
+   unsigned long long   expirations;
+   int                  msec;
+
+   // drain expiration count. it fails with EAGAIN when not expired yet
+   if(read(timer->fd, &expirations, sizeof(expirations)) < 0)
+   {
+      expirations = 0;
+   }
+
+   now = read_timer_clock(timer);
+   if(timer->mode == TIMER_MODE_ORDERED)
+   {
+      deadline = get_timer_deadline(timer);
+   }
+   else
+   {
+      msec  = get_timer_timeout(timer, -1);
+      if(msec >= 0)
+      {
+         deadline = now + msec * 1000000ULL;
+      }
+   }
+
+   timer->fd_deadline = deadline;
+   arm_timer_fd(timer, deadline, now);
+}
+
+static struct list_head*
+get_timer_bucket(Timer* timer, unsigned int tick)
+{
+   unsigned int   delta;
+   int            level;
+
+   if(timer->mode == TIMER_MODE_WHEEL)
+   {
+      return &timer->buckets[tick % timer->num_buckets];
+   }
+
+   delta = tick - timer->tick;
+   if(delta < TIMER_WHEEL_L0_SIZE)
+   {
+      return &timer->buckets[tick & TIMER_WHEEL_L0_MASK];
+   }
+
+   for(level = 1; level < TIMER_WHEEL_LEVELS - 1; level++)
+   {
+      if(delta < (1U << (TIMER_WHEEL_SHIFT(level) + TIMER_WHEEL_LN_BITS)))
+      {
+         break;
+      }
+   }
+
+   return &timer->buckets[TIMER_WHEEL_INDEX(level,
+         (tick >> TIMER_WHEEL_SHIFT(level)) & TIMER_WHEEL_LN_MASK)];
+}
+
+//
+// moves all the timers in a bucket of the given level down to lower levels
+// returns the slot index so that the caller knows whether the level wrapped
+//
+static int
+cascade_timer(Timer* timer, int level)
+{
+   int               slot;
+   TimerElem         *p, *n;
+   struct list_head  list = LIST_HEAD_INIT(list);
+
+   slot = (timer->tick >> TIMER_WHEEL_SHIFT(level)) & TIMER_WHEEL_LN_MASK;
+
+   list_splice_init(&timer->buckets[TIMER_WHEEL_INDEX(level, slot)], &list);
+
+   list_for_each_entry_safe(p, n, &list, next)
+   {
+      list_add_tail(&p->next, get_timer_bucket(timer, p->tick));
+   }
+   return slot;
+}
+
+//
+// tells whether any upper level bucket is cascaded at the given level 0 wrap
+// around tick. follows the same walk as collect_expired_timer()
+//
+static int
+is_cascade_pending(Timer* timer, unsigned int tick)
+{
+   int   level,
+         slot;
+
+   for(level = 1; level < TIMER_WHEEL_LEVELS; level++)
+   {
+      slot = (tick >> TIMER_WHEEL_SHIFT(level)) & TIMER_WHEEL_LN_MASK;
+      if(!list_empty(&timer->buckets[TIMER_WHEEL_INDEX(level, slot)]))
+      {
+         return 1;
+      }
+      if(slot != 0)
+      {
+         break;
+      }
+   }
+   return 0;
+}
+
+//
+// returns the earliest tick in a non empty bucket of TIMER_MODE_WHEEL.
+// every element in a bucket is at or after the current tick,
+// so ticks are compared by distance from it
+//
+static unsigned int
+get_bucket_min_tick(Timer* timer, int bucket)
+{
+   TimerBucketMin*   min = &timer->bucket_min[bucket];
+   TimerElem*        p;
+
+   if(!min->valid)
+   {
+      min->tick = timer->tick - 1;
+      list_for_each_entry(p, &timer->buckets[bucket], next)
+      {
+         if(p->tick - timer->tick < min->tick - timer->tick)
+         {
+            min->tick = p->tick;
+         }
+      }
+      min->valid = 1;
+   }
+   return min->tick;
+}
+
+static void
+collect_expired_timer(Timer* timer, struct list_head* timeout_list)
+{
+   int               current,
+                     level;
+   TimerElem         *p, *n;
+
+   if(timer->mode == TIMER_MODE_HIERARCHICAL)
+   {
+      //
+      // every element in a level 0 bucket expires at this tick.
+      // upper levels are cascaded down whenever lower level wraps around
+      //
+      current = timer->tick & TIMER_WHEEL_L0_MASK;
+      if(current == 0)
+      {
+         for(level = 1; level < TIMER_WHEEL_LEVELS; level++)
+         {
+            if(cascade_timer(timer, level) != 0)
+            {
+               break;
+            }
+         }
+      }
+
+      list_for_each_entry(p, &timer->buckets[current], next)
+      {
+         timer->num_running--;
+      }
+      list_splice_init(&timer->buckets[current], timeout_list);
+      return;
+   }
+
+   current = timer->tick % timer->num_buckets;
+
+   list_for_each_entry_safe(p, n, &timer->buckets[current], next)
+   {
+      if(p->tick == timer->tick)
+      {
+         list_del(&p->next);
+         list_add_tail(&p->next, timeout_list);
+         timer->num_running--;
+      }
+   }
+
+   // whole bucket is walked anyway. recompute the minimum right away
+   timer->bucket_min[current].valid = 0;
+   if(!list_empty(&timer->buckets[current]))
+   {
+      get_bucket_min_tick(timer, current);
+   }
+}
+
 /**
  * initialize a timer manager
  *
@@ -22,18 +498,69 @@
  */
 int
 init_timer(Timer* timer, int tick_rate, int n_buckets)
+{
+   return init_timer_mode(timer, tick_rate, n_buckets, TIMER_MODE_WHEEL);
+}
+
+/**
+ * initialize a timer manager with a given bucket management mode
+ * with TIMER_MODE_HIERARCHICAL, n_buckets is ignored and each tick only
+ * touches timers expiring at the tick plus occasional cascades.
+ * with TIMER_MODE_ORDERED, timers are kept in a tree ordered by nanosecond
+ * deadline and expire exactly at their deadline. tick_rate and n_buckets
+ * are ignored and drive_timer() can be called at any interval
+ *
+ * @param timer timer manager context block
+ * @param tick_rate desired tick rate
+ * @param n_buckets number of buckets desired
+ * @param mode bucket management mode
+ * @return 0 on success, -1 on failure
+ */
+int
+init_timer_mode(Timer* timer, int tick_rate, int n_buckets, TimerMode mode)
 {
    int i;
 
+   if(mode == TIMER_MODE_HIERARCHICAL)
+   {
+      n_buckets = TIMER_WHEEL_BUCKETS;
+   }
+   else if(mode == TIMER_MODE_ORDERED)
+   {
+      n_buckets = 0;
+   }
+
+   timer->mode                = mode;
    timer->num_buckets         = n_buckets;
    timer->tick_rate           = tick_rate;
-   timer->tick_rate_times_3   = tick_rate * 3;
+   timer->tick_nsec           = tick_rate * 1000000LL;
    timer->tick                =      0;
+   timer->num_running         =      0;
+   timer->root                = RB_ROOT;
+   timer->first               = NULL;
+   timer->buckets             = NULL;
+   timer->bucket_min          = NULL;
+   timer->fd                  = -1;
+   timer->fd_deadline         = 0;
 
-   timer->buckets = (struct list_head*)malloc(sizeof(struct list_head) * timer->num_buckets);
-   if(timer->buckets == NULL)
+   if(timer->num_buckets > 0)
    {
-      return -1;
+      timer->buckets = (struct list_head*)malloc(sizeof(struct list_head) * timer->num_buckets);
+      if(timer->buckets == NULL)
+      {
+         return -1;
+      }
+   }
+
+   if(mode == TIMER_MODE_WHEEL)
+   {
+      timer->bucket_min = (TimerBucketMin*)calloc(timer->num_buckets, sizeof(TimerBucketMin));
+      if(timer->bucket_min == NULL)
+      {
+         free(timer->buckets);
+         timer->buckets = NULL;
+         return -1;
+      }
    }
 
    for(i = 0; i < timer->num_buckets; i++)
@@ -41,12 +568,9 @@ init_timer(Timer* timer, int tick_rate, int n_buckets)
       INIT_LIST_HEAD(&timer->buckets[i]);
    }
 
-   timer->accumulated = timer->tick_rate;
-#ifdef __USE_HIGH_RESOLUTION_TIMER
-   clock_gettime(CLOCK_MONOTONIC, &timer->prev);
-#else
-   gettimeofday(&timer->prev, NULL);
-#endif
+   timer->accumulated = timer->tick_nsec;
+   timer->clock       = TIMER_CLOCK_MONOTONIC;
+   timer->prev        = read_timer_clock(timer);
    return 0;
 }
 
@@ -59,6 +583,13 @@ void
 deinit_timer(Timer* timer)
 {
    free(timer->buckets);
+   free(timer->bucket_min);
+
+   if(timer->fd >= 0)
+   {
+      close(timer->fd);
+      timer->fd = -1;
+   }
 }
 
 /**
@@ -70,6 +601,7 @@ void
 init_timer_elem(TimerElem* elem)
 {
    INIT_LIST_HEAD(&elem->next);
+   RB_CLEAR_NODE(&elem->node);
 }
 
 /**
@@ -82,7 +614,10 @@ init_timer_elem(TimerElem* elem)
 void
 add_timer(Timer* timer, TimerElem* elem, int expires)
 {
-   int target;
+   unsigned long long   now;
+   unsigned int         pending;
+   int                  bucket;
+   TimerBucketMin*      min;
 
    if(is_timer_running(elem))
    {
@@ -90,12 +625,73 @@ add_timer(Timer* timer, TimerElem* elem, int expires)
       *crash = 0;
    }
 
+   if(timer->mode == TIMER_MODE_ORDERED)
+   {
+      add_timer_at(timer, elem, read_timer_clock(timer) + expires * 1000000ULL);
+      return;
+   }
+
    INIT_LIST_HEAD(&elem->next);
 
-   elem->tick     = timer->tick + get_tick_from_milsec(timer, expires);
-   target         = elem->tick % timer->num_buckets;
+   //
+   // ticks due since the previous drive_timer() call are run by
+   // the next call before anything else. count them in, or a timer
+   // added after an idle wait would expire in the catch up
+   //
+   now            = read_timer_clock(timer);
+   pending        = (timer->accumulated + get_elapsed_nsec(timer, now)) / timer->tick_nsec;
+   elem->tick     = timer->tick + pending + get_tick_from_milsec(timer, expires);
+
+   if(timer->mode == TIMER_MODE_WHEEL)
+   {
+      bucket = elem->tick % timer->num_buckets;
+      min    = &timer->bucket_min[bucket];
 
-   list_add_tail(&elem->next, &timer->buckets[target]);
+      if(list_empty(&timer->buckets[bucket]))
+      {
+         min->tick  = elem->tick;
+         min->valid = 1;
+      }
+      else if(elem->tick - timer->tick < min->tick - timer->tick)
+      {
+         min->tick  = elem->tick;
+      }
+   }
+
+   list_add_tail(&elem->next, get_timer_bucket(timer, elem->tick));
+   timer->num_running++;
+
+   if(timer->fd >= 0)
+   {
+      update_timer_fd(timer, get_tick_deadline(timer, elem->tick, now), now);
+   }
+}
+
+/**
+ * start a stopped timer element with an absolute deadline
+ * only for TIMER_MODE_ORDERED
+ *
+ * @param timer timer manager context block
+ * @param elem new timer element to add to timer manager
+ * @param deadline absolute deadline in nanoseconds of get_timer_now()
+ */
+void
+add_timer_at(Timer* timer, TimerElem* elem, unsigned long long deadline)
+{
+   if(timer->mode != TIMER_MODE_ORDERED || is_timer_running(elem))
+   {
+      char* crash = NULL;
+      *crash = 0;
+   }
+
+   elem->deadline = deadline;
+   insert_ordered_timer(timer, elem);
+   timer->num_running++;
+
+   if(timer->fd >= 0)
+   {
+      update_timer_fd(timer, deadline, read_timer_clock(timer));
+   }
 }
 
 /**
@@ -111,18 +707,34 @@ del_timer(Timer* timer, TimerElem* elem)
    {
       return;
    }
+
+   if(timer->mode == TIMER_MODE_ORDERED)
+   {
+      // expired elements waiting for callback are not counted as running
+      if(!RB_EMPTY_NODE(&elem->node))
+      {
+         erase_ordered_timer(timer, elem);
+         timer->num_running--;
+      }
+      list_del_init(&elem->next);
+      return;
+   }
+
+   if(timer->mode == TIMER_MODE_WHEEL &&
+      timer->bucket_min[elem->tick % timer->num_buckets].tick == elem->tick)
+   {
+      timer->bucket_min[elem->tick % timer->num_buckets].valid = 0;
+   }
+
    list_del_init(&elem->next);
+   timer->num_running--;
 }
 
 static void
 timer_tick(Timer* timer)
 {
-   int               current;
-   TimerElem         *p, *n;
    struct list_head  timeout_list = LIST_HEAD_INIT(timeout_list);
 
-   current = timer->tick % timer->num_buckets;
-
    //
    // be careful with this code..
    // Here is the logic behind this
@@ -130,23 +742,11 @@ timer_tick(Timer* timer)
    // 2. when a timer expires, it should be able to remove
    //    other timers including ones timed out inside the timeout handler
    //
-   list_for_each_entry_safe(p, n, &timer->buckets[current], next)
-   {
-      if(p->tick == timer->tick)
-      {
-         list_del(&p->next);
-         list_add_tail(&p->next, &timeout_list);
-      }
-   }
+   collect_expired_timer(timer, &timeout_list);
 
    timer->tick++;
 
-   while(!list_empty(&timeout_list))
-   {
-      p = list_first_entry(&timeout_list, TimerElem, next);
-      list_del_init(&p->next);
-      p->cb(p);
-   }
+   run_expired_timer(&timeout_list);
 }
 
 /**
@@ -159,44 +759,232 @@ timer_tick(Timer* timer)
 void
 drive_timer(Timer* timer)
 {
-   long              mtime,
-                     seconds,
-                     mseconds;
-#ifdef __USE_HIGH_RESOLUTION_TIMER
-   struct timespec   now;
-
-   clock_gettime(CLOCK_MONOTONIC, &now);
+   unsigned long long   now;
+   long long            elapsed;
 
-   seconds  = now.tv_sec - timer->prev.tv_sec;
-   mseconds = (now.tv_nsec - timer->prev.tv_nsec) / 1000000.0;
+   if(timer->mode == TIMER_MODE_ORDERED)
+   {
+      drive_ordered_timer(timer);
+      if(timer->fd >= 0)
+      {
+         rearm_timer_fd(timer);
+      }
+      return;
+   }
 
+   now      = read_timer_clock(timer);
+   elapsed  = get_elapsed_nsec(timer, now);
    timer->prev = now;
+
+   timer->accumulated += elapsed;
+
+#ifdef NO_TICK_LOSS_COMPENSATION
+   if(timer->accumulated >= timer->tick_nsec)
 #else
-   struct timeval    now;
+   while(timer->accumulated >= timer->tick_nsec)
+#endif
+   {
+      timer->accumulated -= timer->tick_nsec;
+      timer_tick(timer);
+   }
 
-   gettimeofday(&now, NULL);
+   if(timer->fd >= 0)
+   {
+      rearm_timer_fd(timer);
+   }
+}
 
-   seconds  = now.tv_sec   - timer->prev.tv_sec;
-   mseconds = (now.tv_usec  - timer->prev.tv_usec) / 1000.0;
+/**
+ * get time left until the earliest running timer element expires
+ * buckets are scanned up to max_msec ahead, or a whole round when max_msec is negative.
+ * when nothing expires within the scan range, the end of the range is returned
+ * so that the caller can come back and look again
+ *
+ * @param timer timer manager context block
+ * @param max_msec maximum time of interest in milliseconds, negative for no limit
+ * @return milliseconds until next expiry, -1 if no timer is running
+ */
+int
+get_timer_timeout(Timer* timer, int max_msec)
+{
+   int                  d,
+                        max_ticks;
+   long long            nsec;
+   unsigned long long   deadline,
+                        now;
+   unsigned int         tick;
 
-   timer->prev = now;
-#endif
+   if(timer->num_running == 0)
+   {
+      return -1;
+   }
 
-   mtime = (seconds * 1000 + mseconds);
+   now = read_timer_clock(timer);
+   if(timer->mode == TIMER_MODE_ORDERED)
+   {
+      deadline = get_timer_deadline(timer);
+      goto out;
+   }
 
-   // defensive guard against sudden time change
-   mtime = mtime < 0 ? 0 : mtime;
-   mtime = mtime >= timer->tick_rate_times_3  ? timer->tick_rate : mtime;
+   max_ticks = timer->num_buckets;
+   if(max_msec >= 0 && max_msec / timer->tick_rate + 1 < max_ticks)
+   {
+      max_ticks = max_msec / timer->tick_rate + 1;
+   }
 
-   timer->accumulated += mtime;
+   for(d = 0; d < max_ticks; d++)
+   {
+      tick = timer->tick + d;
 
-#ifdef NO_TICK_LOSS_COMPENSATION
-   if(timer->accumulated >= timer->tick_rate)
-#else
-   while(timer->accumulated >= timer->tick_rate)
+      if(timer->mode == TIMER_MODE_HIERARCHICAL)
+      {
+         //
+         // level 0 holds timers expiring within a round of it.
+         // at wrap around, upper level timers are cascaded and
+         // might expire at that tick. so wake up there.
+         // the current tick is not processed yet either, so a wrap
+         // around at d == 0 counts as well
+         //
+         if(((tick & TIMER_WHEEL_L0_MASK) == 0 && is_cascade_pending(timer, tick)) ||
+            !list_empty(&timer->buckets[tick & TIMER_WHEEL_L0_MASK]))
+         {
+            goto found;
+         }
+         continue;
+      }
+
+      if(!list_empty(&timer->buckets[tick % timer->num_buckets]) &&
+         get_bucket_min_tick(timer, tick % timer->num_buckets) == tick)
+      {
+         goto found;
+      }
+   }
+   d = max_ticks - 1;
+
+found:
+   deadline = get_tick_deadline(timer, timer->tick + d, now);
+
+out:
+   // rounded up, so that the caller doesn't wake up just before the deadline
+   nsec = (long long)(deadline - now);
+   nsec = nsec <= 0 ? 0 : (nsec + 999999) / 1000000;
+   if(max_msec >= 0 && nsec > max_msec)
+   {
+      nsec = max_msec;
+   }
+   return (int)nsec;
+}
+
+/**
+ * get the deadline of the earliest running timer element
+ * only for TIMER_MODE_ORDERED
+ *
+ * @param timer timer manager context block
+ * @return absolute deadline in nanoseconds, 0 if no timer is running
+ */
+unsigned long long
+get_timer_deadline(Timer* timer)
+{
+   if(timer->first == NULL)
+   {
+      return 0;
+   }
+   return rb_entry(timer->first, TimerElem, node)->deadline;
+}
+
+/**
+ * get current time of the clock timer is driven with
+ *
+ * @param timer timer manager context block
+ * @return current time in nanoseconds
+ */
+unsigned long long
+get_timer_now(Timer* timer)
+{
+   return read_timer_clock(timer);
+}
+
+/**
+ * select the clock source timer manager is driven with
+ * TIMER_CLOCK_MONOTONIC is used by default. TIMER_CLOCK_MONOTONIC_COARSE
+ * and TIMER_CLOCK_TSC are cheaper to read and fine for millisecond ticks.
+ * TIMER_CLOCK_REALTIME is the legacy gettimeofday() behavior and clamps
+ * wall clock jumps to a tick.
+ * ordered mode deadlines are in the clock selected, so the clock can't be
+ * changed while ordered mode timers are running
+ *
+ * @param timer timer manager context block
+ * @param clock clock source to use
+ * @return 0 on success, -1 if the clock is not available or timers are running
+ */
+int
+set_timer_clock(Timer* timer, TimerClock clock)
+{
+   struct timespec ts;
+
+   if(timer->mode == TIMER_MODE_ORDERED && timer->num_running > 0)
+   {
+      return -1;
+   }
+
+   switch(clock)
+   {
+   case TIMER_CLOCK_MONOTONIC:
+   case TIMER_CLOCK_REALTIME:
+      break;
+
+   case TIMER_CLOCK_MONOTONIC_COARSE:
+      if(clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) != 0)
+      {
+         return -1;
+      }
+      break;
+
+   case TIMER_CLOCK_TSC:
+#ifdef TIMER_HAVE_TSC
+      pthread_once(&tscOnce, calibrate_tsc);
+      if(tscClock.valid)
+      {
+         break;
+      }
 #endif
+      return -1;
+
+   default:
+      return -1;
+   }
+
+   // time accumulated so far is kept. only the base is moved to the new clock
+   timer->clock   = clock;
+   timer->prev    = read_timer_clock(timer);
+   return 0;
+}
+
+/**
+ * let timer manager arm a timerfd to the next expiry
+ * the fd becomes readable when a timer element expires, so a process can
+ * sleep in poll until then instead of calling drive_timer() every tick.
+ * call drive_timer() when the fd is readable. it re-arms the fd.
+ * del_timer() doesn't re-arm, so a deleted timer might cause
+ * a wake up with nothing to expire
+ *
+ * @param timer timer manager context block
+ * @return timerfd on success, -1 on failure
+ */
+int
+enable_timer_fd(Timer* timer)
+{
+   if(timer->fd >= 0)
    {
-      timer->accumulated -= timer->tick_rate;
-      timer_tick(timer);
+      return timer->fd;
+   }
+
+   timer->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   if(timer->fd < 0)
+   {
+      return -1;
    }
+
+   rearm_timer_fd(timer);
+   return timer->fd;
 }
@@ -12,10 +12,31 @@
 
 #include <sys/time.h>
 #include "list.h"
-
-//#define __USE_HIGH_RESOLUTION_TIMER
+#include "rbtree.h"
 
 struct _timer_elem;
+struct _timer_bucket_min;
+
+/**
+ * timer bucket management mode
+ */
+typedef enum
+{
+   TIMER_MODE_WHEEL = 0,         /** single level wheel of n_buckets           */
+   TIMER_MODE_HIERARCHICAL,      /** multi level cascading wheel               */
+   TIMER_MODE_ORDERED,           /** rbtree ordered by nanosecond deadline     */
+} TimerMode;
+
+/**
+ * clock source timer is driven with
+ */
+typedef enum
+{
+   TIMER_CLOCK_MONOTONIC = 0,    /** clock_gettime(CLOCK_MONOTONIC)            */
+   TIMER_CLOCK_MONOTONIC_COARSE, /** CLOCK_MONOTONIC_COARSE, cheaper, tick resolution */
+   TIMER_CLOCK_TSC,              /** invariant TSC calibrated against CLOCK_MONOTONIC */
+   TIMER_CLOCK_REALTIME,         /** gettimeofday(), follows wall clock jumps   */
+} TimerClock;
 
 /**
  * timer callback function
@@ -30,6 +51,8 @@ typedef struct _timer_elem
    struct list_head  next;       /** a list head for next timer element in the bucket  */
    timer_cb          cb;         /** timeout callback                                  */
    unsigned int      tick;       /** absolute timeout tick count                       */
+   struct rb_node    node;       /** a node in deadline tree for TIMER_MODE_ORDERED    */
+   unsigned long long deadline;  /** absolute deadline in nanoseconds, ordered mode    */
    void*             priv;       /** private argument for timeout callback             */
 } TimerElem;
 
@@ -38,25 +61,36 @@ typedef struct _timer_elem
  */
 typedef struct _timer
 {
+   TimerMode            mode;                /** bucket management mode                         */
    int                  num_buckets;         /** number of buckets for timer management         */
    int                  tick_rate;           /** tick rate 100 means a tick per 0.1 sec         */
-   int                  tick_rate_times_3;   /** pre calculated tick_rate * 3                   */
+   long long            tick_nsec;           /** tick rate in nanoseconds                       */
    unsigned int         tick;                /** current tick                                   */
+   int                  num_running;         /** number of running timer elements               */
    struct list_head*    buckets;             /** bucket array                                   */
-#ifdef __USE_HIGH_RESOLUTION_TIMER
-   struct timespec      prev;
-#else
-   struct timeval       prev;                /** previous tick time                             */
-#endif
-   long                 accumulated;         /** time accumulated so far after previous timck   */
+   struct _timer_bucket_min* bucket_min;     /** earliest tick per bucket, TIMER_MODE_WHEEL     */
+   struct rb_root       root;                /** deadline tree for TIMER_MODE_ORDERED           */
+   struct rb_node*      first;               /** cached earliest deadline node                  */
+   TimerClock           clock;               /** clock source                                   */
+   unsigned long long   prev;                /** previous drive time in nanoseconds             */
+   long long            accumulated;         /** nanoseconds accumulated after previous tick    */
+   int                  fd;                  /** timerfd armed to the next expiry, -1 if unused */
+   unsigned long long   fd_deadline;         /** time timerfd is armed to, 0 if disarmed        */
 } Timer;
 
 extern int init_timer(Timer* timer, int tick_rate, int n_buckets);
+extern int init_timer_mode(Timer* timer, int tick_rate, int n_buckets, TimerMode mode);
 extern void deinit_timer(Timer* timer);
 extern void init_timer_elem(TimerElem* elem);
 extern void add_timer(Timer* timer, TimerElem* elem, int expires);
+extern void add_timer_at(Timer* timer, TimerElem* elem, unsigned long long deadline);
 extern void del_timer(Timer* timer, TimerElem* elem);
 extern void drive_timer(Timer* timer);
+extern int get_timer_timeout(Timer* timer, int max_msec);
+extern unsigned long long get_timer_deadline(Timer* timer);
+extern unsigned long long get_timer_now(Timer* timer);
+extern int enable_timer_fd(Timer* timer);
+extern int set_timer_clock(Timer* timer, TimerClock clock);
 
 /**
  * check if a given timer element is currently running
@@ -67,7 +101,8 @@ extern void drive_timer(Timer* timer);
 static inline int
 is_timer_running(TimerElem* elem)
 {
-   if(elem->next.next == &elem->next && elem->next.prev == &elem->next)
+   if(elem->next.next == &elem->next && elem->next.prev == &elem->next &&
+      RB_EMPTY_NODE(&elem->node))
    {
       return 0;
    }